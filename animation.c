@@ -25,8 +25,7 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 #include "animation.h"
 
-#include <SDL_image.h>
-
+#include "image.h"
 #include "init.h"
 
 
@@ -34,7 +33,7 @@ bool AnimationLoad(
 	Animation *a, const char *filename, const int w, const int h,
 	const int frameRate)
 {
-	a->image = IMG_Load(filename);
+	a->image = ImageLoad(filename);
 	if (a->image == NULL) goto bail;
 	a->w = w;
 	a->h = h;
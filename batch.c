@@ -0,0 +1,285 @@
+#include "batch.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "SDL.h"
+
+#include "context.h"
+#include "main.h"
+#include "rng.h"
+#include "title.h"
+#include "utils.h"
+
+#define BATCH_MAX_THREADS 256
+
+
+typedef struct
+{
+	GameResult Result;
+	// Still going when the frame limit was reached
+	bool Capped;
+} BatchGame;
+
+// Each worker owns a range of games, which it plays from the front. Once
+// its own range is used up it steals the back half of another worker's, so
+// that workers that draw long games don't hold up the rest.
+typedef struct
+{
+	pthread_t Thread;
+	int Id;
+	pthread_mutex_t Lock;
+	int Next;
+	int End;
+} Worker;
+
+static Worker *workers;
+static int numWorkers;
+static BatchGame *results;
+static int batchMaxFrames;
+static uint32_t batchSeed;
+static int batchPlayers;
+
+
+static void *WorkerRun(void *data);
+static void PrintStats(const int games, const Uint32 ms);
+void BatchRun(const int games, const int maxFrames, const int threads)
+{
+	numWorkers = threads;
+	if (numWorkers <= 0)
+	{
+		numWorkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	numWorkers = CLAMP(numWorkers, 1, MIN(games, BATCH_MAX_THREADS));
+	batchMaxFrames = maxFrames;
+	batchSeed = Game->Seed != 0 ? Game->Seed : 1;
+	batchPlayers = Game->PlayerState.Count;
+	printf(
+		"Batch of %d games, %d players, seeds %u-%u, %d threads\n",
+		games, batchPlayers, (unsigned)batchSeed,
+		(unsigned)(batchSeed + games - 1), numWorkers);
+
+	results = calloc(games, sizeof *results);
+	workers = calloc(numWorkers, sizeof *workers);
+	if (results == NULL || workers == NULL)
+	{
+		printf("Error: cannot allocate batch of %d games\n", games);
+		free(results);
+		free(workers);
+		return;
+	}
+	// Start with the games split evenly
+	for (int i = 0; i < numWorkers; i++)
+	{
+		Worker *w = &workers[i];
+		w->Id = i;
+		pthread_mutex_init(&w->Lock, NULL);
+		w->Next = (int)((int64_t)games * i / numWorkers);
+		w->End = (int)((int64_t)games * (i + 1) / numWorkers);
+	}
+
+	const Uint32 start = SDL_GetTicks();
+	int started;
+	for (started = 0; started < numWorkers; started++)
+	{
+		if (pthread_create(
+			&workers[started].Thread, NULL, WorkerRun, &workers[started]) != 0)
+		{
+			printf("Error: cannot start batch thread %d\n", started);
+			break;
+		}
+	}
+	// Games of workers that failed to start are stolen by the others
+	if (started == 0)
+	{
+		WorkerRun(&workers[0]);
+	}
+	for (int i = 0; i < started; i++)
+	{
+		pthread_join(workers[i].Thread, NULL);
+	}
+	const Uint32 elapsed = MAX(SDL_GetTicks() - start, 1);
+
+	PrintStats(games, elapsed);
+
+	for (int i = 0; i < numWorkers; i++)
+	{
+		pthread_mutex_destroy(&workers[i].Lock);
+	}
+	free(workers);
+	free(results);
+}
+
+static bool TakeGame(Worker *w, int *game);
+static bool StealGames(Worker *w);
+static void PlayGame(const int game, BatchGame *out);
+static void *WorkerRun(void *data)
+{
+	Worker *w = data;
+	GameContext *c = malloc(sizeof *c);
+	if (c == NULL)
+	{
+		printf("Error: cannot allocate game for batch thread %d\n", w->Id);
+		return NULL;
+	}
+	GameContextInit(c, batchPlayers, true);
+	GameContext *prev = Game;
+	Game = c;
+	for (;;)
+	{
+		int game;
+		if (TakeGame(w, &game))
+		{
+			PlayGame(game, &results[game]);
+		}
+		else if (!StealGames(w))
+		{
+			// Nothing left anywhere; games are never added, so we're done
+			break;
+		}
+	}
+	Game = prev;
+	GameContextFree(c);
+	free(c);
+	return NULL;
+}
+static bool TakeGame(Worker *w, int *game)
+{
+	pthread_mutex_lock(&w->Lock);
+	const bool ok = w->Next < w->End;
+	if (ok)
+	{
+		*game = w->Next++;
+	}
+	pthread_mutex_unlock(&w->Lock);
+	return ok;
+}
+static bool StealGames(Worker *w)
+{
+	for (int i = 1; i < numWorkers; i++)
+	{
+		Worker *victim = &workers[(w->Id + i) % numWorkers];
+		pthread_mutex_lock(&victim->Lock);
+		const int left = victim->End - victim->Next;
+		if (left <= 0)
+		{
+			pthread_mutex_unlock(&victim->Lock);
+			continue;
+		}
+		// Take the back half, rounding up so that the last game goes too
+		const int end = victim->End;
+		victim->End -= (left + 1) / 2;
+		const int next = victim->End;
+		pthread_mutex_unlock(&victim->Lock);
+
+		pthread_mutex_lock(&w->Lock);
+		w->Next = next;
+		w->End = end;
+		pthread_mutex_unlock(&w->Lock);
+		return true;
+	}
+	return false;
+}
+static void PlayGame(const int game, BatchGame *out)
+{
+	Game->Seed = batchSeed + (uint32_t)game;
+	RngSeedAll(Game->Seed);
+	ToTitleScreen(true);
+	const int gamesOver = Game->GamesOver;
+	bool cont = true;
+	bool error = false;
+	for (int frames = 0;
+		cont && frames < batchMaxFrames && Game->GamesOver == gamesOver;
+		frames++)
+	{
+		Game->GatherInput(&cont);
+		if (cont)
+		{
+			Game->DoLogic(&cont, &error, HEADLESS_FRAME_MS);
+		}
+	}
+	out->Capped = Game->GamesOver == gamesOver;
+	if (!out->Capped)
+	{
+		out->Result = Game->LastResult;
+		return;
+	}
+	// Score the game as it stands
+	GameResult *r = &out->Result;
+	r->Ms = Game->GameMs;
+	r->NumPlayers = Game->PlayerState.Count;
+	r->MaxScore = 0;
+	for (int i = 0; i < r->NumPlayers; i++)
+	{
+		r->Scores[i] = Game->Players[i].Score;
+		r->MaxScore = MAX(r->MaxScore, r->Scores[i]);
+	}
+}
+
+static void PrintStats(const int games, const Uint32 ms)
+{
+	// Games cut short by the frame limit measure the limit rather than the
+	// game, so the statistics only cover games that ended by themselves
+	double bestSum = 0, bestSqSum = 0, scoreSum = 0, msSum = 0;
+	double cappedBestSum = 0;
+	int bestMin = INT32_MAX, bestMax = 0, ended = 0, scores = 0;
+	uint32_t msMin = UINT32_MAX, msMax = 0;
+	for (int i = 0; i < games; i++)
+	{
+		const BatchGame *g = &results[i];
+		const int best = g->Result.MaxScore;
+		if (g->Capped)
+		{
+			cappedBestSum += best;
+			continue;
+		}
+		ended++;
+		bestSum += best;
+		bestSqSum += (double)best * best;
+		bestMin = MIN(bestMin, best);
+		bestMax = MAX(bestMax, best);
+		for (int j = 0; j < g->Result.NumPlayers; j++)
+		{
+			scoreSum += g->Result.Scores[j];
+			scores++;
+		}
+		msSum += g->Result.Ms;
+		msMin = MIN(msMin, g->Result.Ms);
+		msMax = MAX(msMax, g->Result.Ms);
+	}
+	const int capped = games - ended;
+	printf(
+		"%d of %d games ended, %d hit the limit of %d frames (%.0f s)\n",
+		ended, games, capped, batchMaxFrames,
+		batchMaxFrames * HEADLESS_FRAME_MS * 0.001);
+	if (ended > 0)
+	{
+		const double bestMean = bestSum / ended;
+		const double bestSd =
+			sqrt(MAX(bestSqSum / ended - bestMean * bestMean, 0.0));
+		printf(
+			"Best score: mean %.1f, sd %.1f, min %d, max %d\n",
+			bestMean, bestSd, bestMin, bestMax);
+		printf(
+			"Player score: mean %.1f\n", scores > 0 ? scoreSum / scores : 0.0);
+		printf(
+			"Survival: mean %.1f s, min %.1f s, max %.1f s\n",
+			msSum / ended * 0.001, msMin * 0.001, msMax * 0.001);
+	}
+	else
+	{
+		printf("No game ended; raise the frame limit to get statistics\n");
+	}
+	if (capped > 0)
+	{
+		printf(
+			"Capped games: best score mean %.1f when cut short\n",
+			cappedBestSum / capped);
+	}
+	printf(
+		"Played in %u ms (%.1f games/s)\n",
+		(unsigned)ms, games * 1000.0 / ms);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Play many headless games with bots on a pool of threads and print score
+// and survival statistics, e.g. to compare difficulty settings.
+// Game k is seeded with the --seed (or 1) plus k, so the same batch gives
+// the same statistics whatever the number of threads.
+
+// Games end when every player is out, or are cut short after maxFrames
+// frames; threads is 0 for one per core
+void BatchRun(const int games, const int maxFrames, const int threads);
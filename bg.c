@@ -18,10 +18,11 @@
  */
 #include "bg.h"
 
-#include <SDL_image.h>
-
+#include "context.h"
+#include "image.h"
 #include "init.h"
 #include "main.h"
+#include "rng.h"
 #include "utils.h"
 
 #define ICICLE_WIDTH 58
@@ -39,18 +40,21 @@
 #define STAR_Y_GAP_MIN 0
 #define STAR_Y_GAP_MAX 8
 #define STAR_NUM 4
-#define PARTICLE_RAND_X(_w) (-(_w) + (rand() % ((_w) + SCREEN_WIDTH)))
-#define PARTICLE_RAND_Y(_y, _gmin, _gmax) ((_y) + (_gmin) + (rand() % ((_gmax) - (_gmin))))
-#define PARTICLE_RAND_INDEX(_num) (rand() % (_num))
+#define PARTICLE_RAND_X(_w)\
+	(-(_w) + RngInt(&Game->Rngs[RNG_BACKGROUND], (_w) + SCREEN_WIDTH))
+#define PARTICLE_RAND_Y(_y, _gmin, _gmax)\
+	((_y) + (_gmin) + RngInt(&Game->Rngs[RNG_BACKGROUND], (_gmax) - (_gmin)))
+#define PARTICLE_RAND_INDEX(_num) RngInt(&Game->Rngs[RNG_BACKGROUND], (_num))
 
-#define SCROLL_FACTOR 0.1f
-#define SCALE_1 1.0f
-#define SCALE_2 2.0f
-#define SCALE_3 3.0f
+// Layers scroll by their scale in tenths of the screen scroll
+#define SCROLL_DIVISOR 10
+#define SCALE_1 1
+#define SCALE_2 2
+#define SCALE_3 3
 
 Backgrounds BG;
 
-static void ParticlesInit(
+static void BGParticlesInit(
 	BGParticles *p,
 	const int w, const int gmin, const int gmax, const int num)
 {
@@ -67,13 +71,13 @@ static void ParticlesInit(
 
 void BackgroundsInit(Backgrounds *bg)
 {
-	ParticlesInit(
+	BGParticlesInit(
 		&bg->Icicles,
 		ICICLE_WIDTH, ICICLE_Y_GAP_MIN, ICICLE_Y_GAP_MAX, ICICYLE_NUM);
-	ParticlesInit(
+	BGParticlesInit(
 		&bg->Flares,
 		FLARE_WIDTH, FLARE_Y_GAP_MIN, FLARE_Y_GAP_MAX, FLARE_NUM);
-	ParticlesInit(
+	BGParticlesInit(
 		&bg->Stars,
 		STAR_WIDTH, STAR_Y_GAP_MIN, STAR_Y_GAP_MAX, STAR_NUM);
 }
@@ -81,19 +85,19 @@ void BackgroundsInit(Backgrounds *bg)
 static void DrawParticleScroll(
 	BGParticles *p, const int s,
 	const int w, const int h, const int gmin, const int gmax, const int num);
-void DrawBackground(Backgrounds *bg, const float y)
+void DrawBackground(Backgrounds *bg, const int y)
 {
 	SDL_FillRect(Screen, NULL, SDL_MapRGB(Screen->format, 8, 3, 32));
 	DrawParticleScroll(
-		&bg->Icicles, (int)(y * SCROLL_FACTOR * SCALE_1),
+		&bg->Icicles, y * SCALE_1 / SCROLL_DIVISOR,
 		ICICLE_WIDTH, ICICLE_HEIGHT,
 		ICICLE_Y_GAP_MIN, ICICLE_Y_GAP_MAX, ICICYLE_NUM);
 	DrawParticleScroll(
-		&bg->Flares, (int)(y * SCROLL_FACTOR * SCALE_2),
+		&bg->Flares, y * SCALE_2 / SCROLL_DIVISOR,
 		FLARE_WIDTH, FLARE_HEIGHT,
 		FLARE_Y_GAP_MIN, FLARE_Y_GAP_MAX, FLARE_NUM);
 	DrawParticleScroll(
-		&bg->Stars, (int)(y * SCROLL_FACTOR * SCALE_3),
+		&bg->Stars, y * SCALE_3 / SCROLL_DIVISOR,
 		STAR_WIDTH, STAR_HEIGHT,
 		STAR_Y_GAP_MIN, STAR_Y_GAP_MAX, STAR_NUM);
 }
@@ -154,7 +158,7 @@ static void DrawParticleScroll(
 bool BackgroundsLoad(Backgrounds* bg)
 {
 #define LOAD_SURFACE(_surface, _filename)\
-	_surface = IMG_Load("data/graphics/" _filename);\
+	_surface = ImageLoad("data/graphics/" _filename);\
 	if (_surface == NULL)\
 	{\
 		return false;\
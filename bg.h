@@ -46,7 +46,7 @@ extern Backgrounds BG;
 
 void BackgroundsInit(Backgrounds *bg);
 
-void DrawBackground(Backgrounds *bg, const float y);
+void DrawBackground(Backgrounds *bg, const int y);
 
 bool BackgroundsLoad(Backgrounds *bg);
 void BackgroundsFree(Backgrounds *bg);
@@ -0,0 +1,72 @@
+#include "bot.h"
+
+#include <math.h>
+
+#include "box.h"
+#include "context.h"
+#include "game.h"
+#include "gap.h"
+#include "space.h"
+#include "utils.h"
+
+// Gains for steering toward the target opening; the damping term stops the
+// player from overshooting and bouncing between the walls of the gap
+#define BOT_GAIN_P 4.0f
+#define BOT_GAIN_D 1.0f
+
+float BotSkill = 1.0f;
+
+int16_t BotGetMovement(const Player *p)
+{
+	if (p->Body == NULL) return 0;
+	const PlayerState *ps = &Game->PlayerState;
+	const float x = ps->X[p->Index];
+	const float y = ps->Y[p->Index];
+
+	// Find the first gap that the player hasn't fallen through yet
+	const struct Gap *g = NULL;
+	for (int i = 0; i < Game->Space.NumGaps; i++)
+	{
+		const struct Gap *gi = SpaceGap(&Game->Space, i);
+		if (gi->Y <= y + PLAYER_RADIUS)
+		{
+			g = gi;
+			break;
+		}
+	}
+	if (g == NULL)
+	{
+		// No gaps (title screen); roll off whatever we're standing on
+		return 32767;
+	}
+
+	// Aim for the middle of the opening closest to the player
+	float target = x;
+	float bestDistance = FIELD_WIDTH;
+	for (int i = 0; i < g->numBlocks - 1; i++)
+	{
+		const Block *bl = &g->blocks[i];
+		const float left = bl->X + bl->W / 2;
+		const Block *br = &g->blocks[i + 1];
+		const float right = br->X - br->W / 2;
+		const float mid = (left + right) / 2;
+		if (fabsf(mid - x) < bestDistance)
+		{
+			bestDistance = fabsf(mid - x);
+			target = mid;
+		}
+	}
+
+	const float u = BotSkill *
+		((target - x) * BOT_GAIN_P - ps->VX[p->Index] * BOT_GAIN_D);
+	return (int16_t)CLAMP(u * 32767, -32768, 32767);
+}
+
+void BotGatherInput(bool* Continue)
+{
+	UNUSED(Continue);
+	for (int i = 0; i < Game->PlayerState.Count; i++)
+	{
+		Game->PlayerState.AccelX[i] = BotGetMovement(&Game->Players[i]);
+	}
+}
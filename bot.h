@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "player.h"
+
+// Simple autopilot used when there is no human at the controls.
+// Returns a movement value in the same range as GetMovement, steering the
+// player toward the nearest opening of the next gap below it.
+int16_t BotGetMovement(const Player *p);
+
+// How hard the bots steer, from 1 for full strength; lower values make
+// weaker bots whose games end sooner
+extern float BotSkill;
+
+// Drop-in replacement for the GatherInput functions; all players are bots
+void BotGatherInput(bool* Continue);
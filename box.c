@@ -25,66 +25,90 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 #include "box.h"
 
-#include <SDL_image.h>
+#include <chipmunk/chipmunk_unsafe.h>
 
+#include "context.h"
 #include "game.h"
 #include "gap.h"
 #include "main.h"
+#include "rng.h"
 #include "space.h"
 #include "utils.h"
 
 #define BLOCK_SPRITE_HEIGHT 15
 
-static cpBody *MakeBody(const float x, const float y, const float w);
 static SDL_Surface *RandomSurface(void);
 void BlockInit(Block *block, const float x, const float y, const float w)
 {
-	block->Body = MakeBody(x, y, w);
+	block->Shape = NULL;
+	block->X = x + w / 2;
+	block->Y = y - GAP_HEIGHT / 2;
 	block->W = w;
 	block->H = GAP_HEIGHT;
+	block->ScreenX = SCREEN_X(block->X - block->W / 2);
+	block->ScreenY = SCREEN_Y(block->Y + block->H / 2);
+	block->ScreenW = SCREEN_X(block->W);
 	block->Surface = RandomSurface();
 }
-static cpBody *MakeBody(const float x, const float y, const float w)
-{
-	cpBody *body = cpSpaceAddBody(space.Space, cpBodyNewStatic());
-	cpBodySetPosition(body, cpv(x + w / 2, y - GAP_HEIGHT / 2));
-	cpShape *shape = cpSpaceAddShape(
-		space.Space, cpBoxShapeNew(body, w, GAP_HEIGHT, 0.0));
-	cpShapeSetElasticity(shape, BLOCK_ELASTICITY);
-	cpShapeSetFriction(shape, 1.0f);
-	return body;
-}
 static SDL_Surface *RandomSurface(void)
 {
-	return GapSurfaces[rand() % 6];
+	return GapSurfaces[RngInt(&Game->Rngs[RNG_BLOCKS], 6)];
 }
 
-static void RemoveShape(cpBody *body, cpShape *shape, void *data);
-void BlockRemove(Block *block)
+static cpShape *MakeShape(const cpBB bb);
+void BlocksAdd(Block *blocks, const int n)
 {
-	cpBodyEachShape(block->Body, RemoveShape, space.Space);
-	cpSpaceRemoveBody(space.Space, block->Body);
+	for (int i = 0; i < n; i++)
+	{
+		Block *b = &blocks[i];
+		b->Shape = cpSpaceAddShape(Game->Space.Space, MakeShape(cpBBNewForExtents(
+			cpv(b->X, b->Y), b->W / 2, b->H / 2)));
+	}
+}
+static cpShape *MakeShape(const cpBB bb)
+{
+	// Reuse a spare shape if there is one; blocks are all 4-sided boxes, so
+	// their vertices fit in the shape without reallocating
+	if (Game->Space.BlockShapes.size > 0)
+	{
+		const int last = (int)Game->Space.BlockShapes.size - 1;
+		cpShape *shape = *(cpShape **)CArrayGet(&Game->Space.BlockShapes, last);
+		CArrayDelete(&Game->Space.BlockShapes, last);
+		cpVect verts[] =
+		{
+			cpv(bb.r, bb.b), cpv(bb.r, bb.t), cpv(bb.l, bb.t), cpv(bb.l, bb.b)
+		};
+		cpPolyShapeSetVertsRaw(shape, 4, verts);
+		return shape;
+	}
+	cpShape *shape =
+		cpBoxShapeNew2(cpSpaceGetStaticBody(Game->Space.Space), bb, 0.0);
+	cpShapeSetElasticity(shape, BLOCK_ELASTICITY);
+	cpShapeSetFriction(shape, 1.0f);
+	return shape;
 }
-static void RemoveShape(cpBody *body, cpShape *shape, void *data)
+void BlocksRemove(Block *blocks, const int n)
 {
-	UNUSED(body);
-	cpSpace *s = data;
-	cpSpaceRemoveShape(s, shape);
-	cpShapeFree(shape);
+	for (int i = 0; i < n; i++)
+	{
+		cpSpaceRemoveShape(Game->Space.Space, blocks[i].Shape);
+		CArrayPushBack(&Game->Space.BlockShapes, &blocks[i].Shape);
+		blocks[i].Shape = NULL;
+	}
 }
 
-void BlockDraw(const Block *block, const float y)
+void BlockSprite(const Block *block, DrawSprite *sprite)
 {
-	const cpVect pos = cpBodyGetPosition(block->Body);
-	SDL_Rect src =
-	{
-		0, 0, (Sint16)SCREEN_X(block->W), (Sint16)block->Surface->h
+	sprite->Surface = block->Surface;
+	sprite->Src = (SDL_Rect){
+		0, 0, (Uint16)block->ScreenW, (Uint16)block->Surface->h
 	};
-	SDL_Rect dest =
-	{
-		(Sint16)SCREEN_X((float)pos.x - block->W / 2),
-		(Sint16)(SCREEN_Y((float)pos.y + block->H / 2) - y),
-		0, 0
-	};
-	SDL_BlitSurface(block->Surface, &src, Screen, &dest);
+	sprite->X = block->ScreenX;
+	sprite->Y = block->ScreenY;
+}
+void BlockDraw(const Block *block, const int y)
+{
+	DrawSprite sprite;
+	BlockSprite(block, &sprite);
+	DRAW_Sprite(&sprite, Screen, y);
 }
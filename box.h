@@ -28,14 +28,26 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <chipmunk/chipmunk.h>
 #include <SDL.h>
 
-// Rectangular block with body
+#include "draw.h"
+
+// Rectangular block, a box shape on the static body of the space
 typedef struct
 {
-	cpBody *Body;
+	cpShape *Shape;
+	// Centre
+	float X, Y;
 	float W, H;
+	// Top left corner and width on screen, before scrolling; blocks don't
+	// move, so they are worked out once
+	int ScreenX, ScreenY, ScreenW;
 	SDL_Surface *Surface;
 } Block;
 
+// Set up the block without adding it to the physics space
 void BlockInit(Block *block, const float x, const float y, const float w);
-void BlockRemove(Block *block);
-void BlockDraw(const Block *block, const float y);
+// Add or remove the shapes of a run of blocks in one go; removed shapes are
+// kept by the space for the next blocks
+void BlocksAdd(Block *blocks, const int n);
+void BlocksRemove(Block *blocks, const int n);
+void BlockSprite(const Block *block, DrawSprite *sprite);
+void BlockDraw(const Block *block, const int y);
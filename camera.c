@@ -25,27 +25,45 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 #include "camera.h"
 
+#include <math.h>
+
 #include "game.h"
 #include "utils.h"
 
 // The rate at which the camera tracks the target position
-// Every frame it will pan from its current position to the target with
-// this ratio
+// Every CAMERA_TRACK_MS it will pan from its current position to the target
+// with this ratio, however long the logic steps are
 #define CAMERA_TRACK_RATIO 0.1f
-
-Camera camera;
+#define CAMERA_TRACK_MS 16.0f
 
 void CameraInit(Camera *c)
 {
 	// Initialise camera so that players are at the bottom
 	c->Y = FIELD_HEIGHT * (0.5f + 0.75f) - PLAYER_RADIUS;
 	c->DY = c->Y;
+	c->PrevY = c->Y;
 	c->ScrollRate = FIELD_SCROLL;
 	c->ScrollCounter = 0;
+	c->trackMs = 0;
+	c->trackRatio = 0;
+}
+
+static float TrackRatio(Camera *c, const uint32_t ms)
+{
+	if (ms != c->trackMs)
+	{
+		c->trackMs = ms;
+		c->trackRatio =
+			1 - powf(1 - CAMERA_TRACK_RATIO, ms / CAMERA_TRACK_MS);
+	}
+	return c->trackRatio;
 }
 
 void CameraUpdate(Camera *c, const float playerY, const uint32_t ms)
 {
+	c->PrevY = c->Y;
+	// No live players; hold the camera rather than let it go NaN
+	if (isnan(playerY)) return;
 	c->DY -= ms * c->ScrollRate / 1000;
 	float targetY;
 	if (c->DY < playerY)
@@ -57,7 +75,8 @@ void CameraUpdate(Camera *c, const float playerY, const uint32_t ms)
 		targetY = 0.8f * playerY + 0.2f * c->DY;
 	}
 
-	c->Y = c->Y * (1 - CAMERA_TRACK_RATIO) + targetY * CAMERA_TRACK_RATIO;
+	const float ratio = TrackRatio(c, ms);
+	c->Y = c->Y * (1 - ratio) + targetY * ratio;
 
 	c->DY = MIN(c->DY, playerY + FIELD_HEIGHT / 2);
 	c->ScrollCounter += ms;
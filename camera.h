@@ -31,10 +31,14 @@ typedef struct
 {
 	float DY;
 	float Y;
+	// Y before the last update, to draw between the two
+	float PrevY;
 	float ScrollRate;
 	uint32_t ScrollCounter;
+	// Tracking ratio for steps of trackMs, kept as it is slow to work out
+	uint32_t trackMs;
+	float trackRatio;
 } Camera;
-extern Camera camera;
 
 void CameraInit(Camera *c);
 void CameraUpdate(Camera *c, const float playerY, const uint32_t ms);
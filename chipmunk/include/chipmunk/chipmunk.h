@@ -143,6 +143,12 @@ typedef struct cpSpace cpSpace;
 /// Version string.
 extern const char *cpVersionString;
 
+/// Tracing callback, called with @c begin set at the start of each phase of cpSpaceStep() and cleared at its end.
+/// Calls are properly nested.
+typedef void (*cpTraceFunc)(const char *name, cpBool begin);
+/// Set to receive cpSpaceStep() phase events. NULL (the default) disables tracing.
+extern cpTraceFunc cpTraceHook;
+
 /// Calculate the moment of inertia for a circle.
 /// @c r1 and @c r2 are the inner and outer diameters. A solid circle has an inner diameter of 0.
 cpFloat cpMomentForCircle(cpFloat m, cpFloat r1, cpFloat r2, cpVect offset);
@@ -27,12 +27,19 @@
 #define CP_ALLOW_PRIVATE_ACCESS 1
 #include "chipmunk/chipmunk.h"
 
+#if CP_FIXED_SOLVER
+#include "chipmunk/cpFixed.h"
+#endif
+
 #define CP_HASH_COEF (3344921057ul)
 #define CP_HASH_PAIR(A, B) ((cpHashValue)(A)*CP_HASH_COEF ^ (cpHashValue)(B)*CP_HASH_COEF)
 
 // TODO: Eww. Magic numbers.
 #define MAGIC_EPSILON 1e-5
 
+#define cpTraceBegin(name) do { if(cpTraceHook) cpTraceHook(name, cpTrue); } while(0)
+#define cpTraceEnd(name) do { if(cpTraceHook) cpTraceHook(name, cpFalse); } while(0)
+
 
 //MARK: cpArray
 
@@ -112,6 +119,14 @@ struct cpBody {
 	cpVect v_bias;
 	cpFloat w_bias;
 	
+#if CP_FIXED_SOLVER
+	// The velocities and inverse masses above, while the fixed point
+	// solver runs.
+	cpFixedVect fixed_v, fixed_v_bias;
+	cpFixed fixed_w, fixed_w_bias;
+	cpFixed fixed_m_inv, fixed_i_inv;
+#endif
+	
 	cpSpace *space;
 	
 	cpShape *shapeList;
@@ -168,6 +183,13 @@ struct cpContact {
 	cpFloat jnAcc, jtAcc, jBias;
 	cpFloat bias;
 	
+#if CP_FIXED_SOLVER
+	cpFixedVect fixed_r1, fixed_r2;
+	cpFixed fixed_nMass, fixed_tMass, fixed_bounce;
+	cpFixed fixed_jnAcc, fixed_jtAcc, fixed_jBias;
+	cpFixed fixed_bias;
+#endif
+	
 	cpHashValue hash;
 };
 
@@ -197,6 +219,11 @@ struct cpArbiter {
 	struct cpContact *contacts;
 	cpVect n;
 	
+#if CP_FIXED_SOLVER
+	cpFixed fixed_u;
+	cpFixedVect fixed_surface_vr, fixed_n;
+#endif
+	
 	// Regular, wildcard A and wildcard B collision handlers.
 	cpCollisionHandler *handler, *handlerA, *handlerB;
 	cpBool swapped;
@@ -220,6 +247,14 @@ void cpArbiterPreStep(cpArbiter *arb, cpFloat dt, cpFloat bias, cpFloat slop);
 void cpArbiterApplyCachedImpulse(cpArbiter *arb, cpFloat dt_coef);
 void cpArbiterApplyImpulse(cpArbiter *arb);
 
+#if CP_FIXED_SOLVER
+// Copy the solver state of the arbiter and its bodies to fixed point, solve
+// on that, and copy the results back.
+void cpArbiterToFixed(cpArbiter *arb);
+void cpArbiterApplyImpulseFixed(cpArbiter *arb);
+void cpArbiterFromFixed(cpArbiter *arb);
+#endif
+
 
 //MARK: Shapes/Collisions
 
@@ -574,6 +609,45 @@ apply_bias_impulses(cpBody *a , cpBody *b, cpVect r1, cpVect r2, cpVect j)
 	apply_bias_impulse(b, j, r2);
 }
 
+#if CP_FIXED_SOLVER
+
+static inline cpFixedVect
+relative_velocity_fixed(cpBody *a, cpBody *b, cpFixedVect r1, cpFixedVect r2){
+	cpFixedVect v1_sum = cpfxvadd(a->fixed_v, cpfxvmult(cpfxvperp(r1), a->fixed_w));
+	cpFixedVect v2_sum = cpfxvadd(b->fixed_v, cpfxvmult(cpfxvperp(r2), b->fixed_w));
+	
+	return cpfxvsub(v2_sum, v1_sum);
+}
+
+static inline void
+apply_impulse_fixed(cpBody *body, cpFixedVect j, cpFixedVect r){
+	body->fixed_v = cpfxvadd(body->fixed_v, cpfxvmult(j, body->fixed_m_inv));
+	body->fixed_w += cpfxmul(body->fixed_i_inv, cpfxvcross(r, j));
+}
+
+static inline void
+apply_impulses_fixed(cpBody *a , cpBody *b, cpFixedVect r1, cpFixedVect r2, cpFixedVect j)
+{
+	apply_impulse_fixed(a, cpfxvneg(j), r1);
+	apply_impulse_fixed(b, j, r2);
+}
+
+static inline void
+apply_bias_impulse_fixed(cpBody *body, cpFixedVect j, cpFixedVect r)
+{
+	body->fixed_v_bias = cpfxvadd(body->fixed_v_bias, cpfxvmult(j, body->fixed_m_inv));
+	body->fixed_w_bias += cpfxmul(body->fixed_i_inv, cpfxvcross(r, j));
+}
+
+static inline void
+apply_bias_impulses_fixed(cpBody *a , cpBody *b, cpFixedVect r1, cpFixedVect r2, cpFixedVect j)
+{
+	apply_bias_impulse_fixed(a, cpfxvneg(j), r1);
+	apply_bias_impulse_fixed(b, j, r2);
+}
+
+#endif
+
 static inline cpFloat
 k_scalar_body(cpBody *body, cpVect r, cpVect n)
 {
@@ -57,6 +57,13 @@
 	#define CP_USE_DOUBLES 1
 #endif
 
+#ifndef CP_FIXED_SOLVER
+	// Iterate the contact solver in 16.16 fixed point, for targets without
+	// an FPU. Only cpSpaceStep() does, and only while there are no
+	// constraints.
+	#define CP_FIXED_SOLVER 0
+#endif
+
 /// @defgroup basicTypes Basic Types
 /// Most of these types can be configured at compile time.
 /// @{
@@ -0,0 +1,114 @@
+#ifndef CHIPMUNK_FIXED_H
+#define CHIPMUNK_FIXED_H
+
+#include <stdint.h>
+
+#include "chipmunk_types.h"
+#include "cpVect.h"
+
+/// @defgroup cpFixed cpFixed
+/// 16.16 fixed point scalars and vectors for the contact solver, which runs
+/// on them instead of cpFloat when CP_FIXED_SOLVER is set. Products are
+/// taken in 64 bits and shifted back, so values stay within +/-32768.
+/// @{
+
+typedef int32_t cpFixed;
+typedef struct cpFixedVect{cpFixed x,y;} cpFixedVect;
+
+#define CP_FIXED_SHIFT 16
+#define CP_FIXED_ONE (1 << CP_FIXED_SHIFT)
+
+/// Convert a cpFloat, rounding to nearest and saturating at the range.
+static inline cpFixed cpFixedFromFloat(const cpFloat f)
+{
+	const cpFloat x = f*(cpFloat)CP_FIXED_ONE;
+	if(x >= (cpFloat)INT32_MAX) return INT32_MAX;
+	if(x <= (cpFloat)-INT32_MAX) return -INT32_MAX;
+	return (cpFixed)(x + (x < 0.0f ? -0.5f : 0.5f));
+}
+
+static inline cpFloat cpFixedToFloat(const cpFixed x)
+{
+	return (cpFloat)x*(1.0f/CP_FIXED_ONE);
+}
+
+static inline cpFixed cpfxmul(const cpFixed a, const cpFixed b)
+{
+	return (cpFixed)(((int64_t)a*b) >> CP_FIXED_SHIFT);
+}
+
+static inline cpFixed cpfxmax(const cpFixed a, const cpFixed b)
+{
+	return (a > b) ? a : b;
+}
+
+static inline cpFixed cpfxclamp(const cpFixed f, const cpFixed min, const cpFixed max)
+{
+	return (f < min ? min : (f > max ? max : f));
+}
+
+static inline cpFixedVect cpfxv(const cpFixed x, const cpFixed y)
+{
+	cpFixedVect v = {x, y};
+	return v;
+}
+
+static inline cpFixedVect cpFixedVectFromVect(const cpVect v)
+{
+	return cpfxv(cpFixedFromFloat(v.x), cpFixedFromFloat(v.y));
+}
+
+static inline cpVect cpFixedVectToVect(const cpFixedVect v)
+{
+	return cpv(cpFixedToFloat(v.x), cpFixedToFloat(v.y));
+}
+
+static inline cpFixedVect cpfxvadd(const cpFixedVect v1, const cpFixedVect v2)
+{
+	return cpfxv(v1.x + v2.x, v1.y + v2.y);
+}
+
+static inline cpFixedVect cpfxvsub(const cpFixedVect v1, const cpFixedVect v2)
+{
+	return cpfxv(v1.x - v2.x, v1.y - v2.y);
+}
+
+static inline cpFixedVect cpfxvneg(const cpFixedVect v)
+{
+	return cpfxv(-v.x, -v.y);
+}
+
+static inline cpFixedVect cpfxvmult(const cpFixedVect v, const cpFixed s)
+{
+	return cpfxv(cpfxmul(v.x, s), cpfxmul(v.y, s));
+}
+
+/// Both products are summed before shifting, which loses less than
+/// shifting each.
+static inline cpFixed cpfxvdot(const cpFixedVect v1, const cpFixedVect v2)
+{
+	return (cpFixed)(((int64_t)v1.x*v2.x + (int64_t)v1.y*v2.y) >> CP_FIXED_SHIFT);
+}
+
+static inline cpFixed cpfxvcross(const cpFixedVect v1, const cpFixedVect v2)
+{
+	return (cpFixed)(((int64_t)v1.x*v2.y - (int64_t)v1.y*v2.x) >> CP_FIXED_SHIFT);
+}
+
+static inline cpFixedVect cpfxvperp(const cpFixedVect v)
+{
+	return cpfxv(-v.y, v.x);
+}
+
+/// Rotate v2 by v1, as cpvrotate().
+static inline cpFixedVect cpfxvrotate(const cpFixedVect v1, const cpFixedVect v2)
+{
+	return cpfxv(
+		(cpFixed)(((int64_t)v1.x*v2.x - (int64_t)v1.y*v2.y) >> CP_FIXED_SHIFT),
+		(cpFixed)(((int64_t)v1.x*v2.y + (int64_t)v1.y*v2.x) >> CP_FIXED_SHIFT)
+	);
+}
+
+/// @}
+
+#endif
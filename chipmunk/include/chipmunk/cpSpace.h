@@ -247,6 +247,9 @@ void cpSpaceReindexShapesForBody(cpSpace *space, cpBody *body);
 
 /// Switch the space to use a spatial has as it's spatial index.
 void cpSpaceUseSpatialHash(cpSpace *space, cpFloat dim, int count);
+/// Switch the space to use a y axis sort and sweep as it's spatial index.
+/// Suits spaces that are much taller than they are wide.
+void cpSpaceUseSweepY(cpSpace *space);
 
 
 //MARK: Time Stepping
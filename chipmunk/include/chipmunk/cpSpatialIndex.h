@@ -112,6 +112,17 @@ cpSpatialIndex* cpSweep1DInit(cpSweep1D *sweep, cpSpatialIndexBBFunc bbfunc, cpS
 /// Allocate and initialize a 1D sort and sweep broadphase.
 cpSpatialIndex* cpSweep1DNew(cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex);
 
+//MARK: Y Axis Sweep
+
+typedef struct cpSweepY cpSweepY;
+
+/// Allocate a sort and sweep broadphase along the y axis, kept sorted between steps.
+cpSweepY* cpSweepYAlloc(void);
+/// Initialize a y axis sort and sweep broadphase.
+cpSpatialIndex* cpSweepYInit(cpSweepY *sweep, cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex);
+/// Allocate and initialize a y axis sort and sweep broadphase.
+cpSpatialIndex* cpSweepYNew(cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex);
+
 //MARK: Spatial Index Implementation
 
 typedef void (*cpSpatialIndexDestroyImpl)(cpSpatialIndex *index);
@@ -45,6 +45,8 @@ cpMessage(const char *condition, const char *file, int line, int isError, int is
 
 const char *cpVersionString = XSTR(CP_VERSION_MAJOR)"."XSTR(CP_VERSION_MINOR)"."XSTR(CP_VERSION_RELEASE);
 
+cpTraceFunc cpTraceHook = NULL;
+
 //MARK: Misc Functions
 
 cpFloat
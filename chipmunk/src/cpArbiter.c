@@ -494,3 +494,110 @@ cpArbiterApplyImpulse(cpArbiter *arb)
 		apply_impulses(a, b, r1, r2, cpvrotate(n, cpv(con->jnAcc - jnOld, con->jtAcc - jtOld)));
 	}
 }
+
+#if CP_FIXED_SOLVER
+
+static void
+body_to_fixed(cpBody *body)
+{
+	body->fixed_v = cpFixedVectFromVect(body->v);
+	body->fixed_v_bias = cpFixedVectFromVect(body->v_bias);
+	body->fixed_w = cpFixedFromFloat(body->w);
+	body->fixed_w_bias = cpFixedFromFloat(body->w_bias);
+	body->fixed_m_inv = cpFixedFromFloat(body->m_inv);
+	body->fixed_i_inv = cpFixedFromFloat(body->i_inv);
+}
+
+static void
+body_from_fixed(cpBody *body)
+{
+	// Only dynamic bodies take impulses; leave the others' velocities as they were.
+	if(cpBodyGetType(body) != CP_BODY_TYPE_DYNAMIC) return;
+	
+	body->v = cpFixedVectToVect(body->fixed_v);
+	body->v_bias = cpFixedVectToVect(body->fixed_v_bias);
+	body->w = cpFixedToFloat(body->fixed_w);
+	body->w_bias = cpFixedToFloat(body->fixed_w_bias);
+}
+
+void
+cpArbiterToFixed(cpArbiter *arb)
+{
+	// Bodies touching several arbiters are converted once for each, to the same values.
+	body_to_fixed(arb->body_a);
+	body_to_fixed(arb->body_b);
+	arb->fixed_u = cpFixedFromFloat(arb->u);
+	arb->fixed_surface_vr = cpFixedVectFromVect(arb->surface_vr);
+	arb->fixed_n = cpFixedVectFromVect(arb->n);
+	
+	for(int i=0; i<arb->count; i++){
+		struct cpContact *con = &arb->contacts[i];
+		con->fixed_r1 = cpFixedVectFromVect(con->r1);
+		con->fixed_r2 = cpFixedVectFromVect(con->r2);
+		con->fixed_nMass = cpFixedFromFloat(con->nMass);
+		con->fixed_tMass = cpFixedFromFloat(con->tMass);
+		con->fixed_bounce = cpFixedFromFloat(con->bounce);
+		con->fixed_bias = cpFixedFromFloat(con->bias);
+		con->fixed_jnAcc = cpFixedFromFloat(con->jnAcc);
+		con->fixed_jtAcc = cpFixedFromFloat(con->jtAcc);
+		con->fixed_jBias = cpFixedFromFloat(con->jBias);
+	}
+}
+
+// As cpArbiterApplyImpulse(), on the fixed point copies.
+void
+cpArbiterApplyImpulseFixed(cpArbiter *arb)
+{
+	cpBody *a = arb->body_a;
+	cpBody *b = arb->body_b;
+	cpFixedVect n = arb->fixed_n;
+	cpFixedVect surface_vr = arb->fixed_surface_vr;
+	cpFixed friction = arb->fixed_u;
+
+	for(int i=0; i<arb->count; i++){
+		struct cpContact *con = &arb->contacts[i];
+		cpFixed nMass = con->fixed_nMass;
+		cpFixedVect r1 = con->fixed_r1;
+		cpFixedVect r2 = con->fixed_r2;
+		
+		cpFixedVect vb1 = cpfxvadd(a->fixed_v_bias, cpfxvmult(cpfxvperp(r1), a->fixed_w_bias));
+		cpFixedVect vb2 = cpfxvadd(b->fixed_v_bias, cpfxvmult(cpfxvperp(r2), b->fixed_w_bias));
+		cpFixedVect vr = cpfxvadd(relative_velocity_fixed(a, b, r1, r2), surface_vr);
+		
+		cpFixed vbn = cpfxvdot(cpfxvsub(vb2, vb1), n);
+		cpFixed vrn = cpfxvdot(vr, n);
+		cpFixed vrt = cpfxvdot(vr, cpfxvperp(n));
+		
+		cpFixed jbn = cpfxmul(con->fixed_bias - vbn, nMass);
+		cpFixed jbnOld = con->fixed_jBias;
+		con->fixed_jBias = cpfxmax(jbnOld + jbn, 0);
+		
+		cpFixed jn = -cpfxmul(con->fixed_bounce + vrn, nMass);
+		cpFixed jnOld = con->fixed_jnAcc;
+		con->fixed_jnAcc = cpfxmax(jnOld + jn, 0);
+		
+		cpFixed jtMax = cpfxmul(friction, con->fixed_jnAcc);
+		cpFixed jt = -cpfxmul(vrt, con->fixed_tMass);
+		cpFixed jtOld = con->fixed_jtAcc;
+		con->fixed_jtAcc = cpfxclamp(jtOld + jt, -jtMax, jtMax);
+		
+		apply_bias_impulses_fixed(a, b, r1, r2, cpfxvmult(n, con->fixed_jBias - jbnOld));
+		apply_impulses_fixed(a, b, r1, r2, cpfxvrotate(n, cpfxv(con->fixed_jnAcc - jnOld, con->fixed_jtAcc - jtOld)));
+	}
+}
+
+void
+cpArbiterFromFixed(cpArbiter *arb)
+{
+	body_from_fixed(arb->body_a);
+	body_from_fixed(arb->body_b);
+	
+	for(int i=0; i<arb->count; i++){
+		struct cpContact *con = &arb->contacts[i];
+		con->jnAcc = cpFixedToFloat(con->fixed_jnAcc);
+		con->jtAcc = cpFixedToFloat(con->fixed_jtAcc);
+		con->jBias = cpFixedToFloat(con->fixed_jBias);
+	}
+}
+
+#endif
@@ -3,10 +3,14 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <pthread.h>
-//#include <sys/param.h >
-#include <linux/sysctl.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "chipmunk/chipmunk_private.h"
 #include "chipmunk/cpHastySpace.h"
@@ -172,11 +176,294 @@ cpArbiterApplyImpulse_NEON(cpArbiter *arb)
 
 #endif
 
+//MARK: x86 Batched Solver
+
+// Contacts only depend on each other through the bodies they push, so arbiters
+// that share no dynamic body can be solved side by side, one per SIMD lane.
+// Arbiters are packed into such batches at the start of the solve, with their
+// contact data in lane order. The accumulated impulses are copied back after.
+#if (__AVX__ || __SSE2__) && CP_USE_DOUBLES && !__ARM_NEON__
+#define CP_HASTY_BATCHED 1
+
+#if __AVX__
+#include <immintrin.h>
+#define LANES 4
+typedef __m256d cpFloatxN_t;
+#define vloadN _mm256_loadu_pd
+#define vstoreN _mm256_storeu_pd
+#define vdupN _mm256_set1_pd
+#define vaddN _mm256_add_pd
+#define vsubN _mm256_sub_pd
+#define vmulN _mm256_mul_pd
+#define vminN _mm256_min_pd
+#define vmaxN _mm256_max_pd
+#else
+#include <emmintrin.h>
+#define LANES 2
+typedef __m128d cpFloatxN_t;
+#define vloadN _mm_loadu_pd
+#define vstoreN _mm_storeu_pd
+#define vdupN _mm_set1_pd
+#define vaddN _mm_add_pd
+#define vsubN _mm_sub_pd
+#define vmulN _mm_mul_pd
+#define vminN _mm_min_pd
+#define vmaxN _mm_max_pd
+#endif
+
+// Number of recent batches searched for a free lane before starting a new one.
+#define BATCH_SEARCH 8
+
+struct cpHastyContacts {
+	cpFloat r1x[LANES], r1y[LANES], r2x[LANES], r2y[LANES];
+	cpFloat nMass[LANES], tMass[LANES], bias[LANES], bounce[LANES];
+	cpFloat jBias[LANES], jnAcc[LANES], jtAcc[LANES];
+};
+
+struct cpHastyBatch {
+	int num;
+	// Number of contacts of the arbiter with the most.
+	int count;
+	cpArbiter *arbs[LANES];
+	cpBody *a[LANES], *b[LANES];
+	
+	cpFloat nx[LANES], ny[LANES], u[LANES], svrx[LANES], svry[LANES];
+	cpFloat m_inv_a[LANES], i_inv_a[LANES], m_inv_b[LANES], i_inv_b[LANES];
+	
+	// Unused lanes have zero masses and impulses, which makes them no-ops.
+	struct cpHastyContacts contacts[CP_MAX_CONTACTS_PER_ARBITER];
+};
+
+struct cpHastyBatches {
+	int num, max;
+	struct cpHastyBatch *arr;
+};
+
+// Stands in for the bodies of unused lanes. It is only ever read, as SCATTER
+// skips unused lanes, so all spaces and threads can share it.
+static const cpBody BatchDummyBody;
+
+static cpBool
+BatchHasBody(struct cpHastyBatch *batch, cpBody *body)
+{
+	if(cpBodyGetType(body) != CP_BODY_TYPE_DYNAMIC) return cpFalse;
+	
+	for(int i=0; i<batch->num; i++){
+		if(batch->a[i] == body || batch->b[i] == body) return cpTrue;
+	}
+	
+	return cpFalse;
+}
+
+static void
+BatchAdd(struct cpHastyBatch *batch, cpArbiter *arb)
+{
+	int l = batch->num++;
+	if(arb->count > batch->count) batch->count = arb->count;
+	batch->arbs[l] = arb;
+	batch->a[l] = arb->body_a;
+	batch->b[l] = arb->body_b;
+	
+	batch->nx[l] = arb->n.x;
+	batch->ny[l] = arb->n.y;
+	batch->u[l] = arb->u;
+	batch->svrx[l] = arb->surface_vr.x;
+	batch->svry[l] = arb->surface_vr.y;
+	batch->m_inv_a[l] = arb->body_a->m_inv;
+	batch->i_inv_a[l] = arb->body_a->i_inv;
+	batch->m_inv_b[l] = arb->body_b->m_inv;
+	batch->i_inv_b[l] = arb->body_b->i_inv;
+	
+	for(int i=0; i<arb->count; i++){
+		struct cpContact *con = &arb->contacts[i];
+		struct cpHastyContacts *c = &batch->contacts[i];
+		c->r1x[l] = con->r1.x;
+		c->r1y[l] = con->r1.y;
+		c->r2x[l] = con->r2.x;
+		c->r2y[l] = con->r2.y;
+		c->nMass[l] = con->nMass;
+		c->tMass[l] = con->tMass;
+		c->bias[l] = con->bias;
+		c->bounce[l] = con->bounce;
+		c->jBias[l] = con->jBias;
+		c->jnAcc[l] = con->jnAcc;
+		c->jtAcc[l] = con->jtAcc;
+	}
+}
+
+static struct cpHastyBatch *
+BatchNew(struct cpHastyBatches *batches);
+
+static void
+BatchArbiters(struct cpHastyBatches *batches, cpArray *arbiters)
+{
+	batches->num = 0;
+	
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		
+		struct cpHastyBatch *batch = NULL;
+		for(int j=batches->num - 1; j>=0 && j>=batches->num - BATCH_SEARCH; j--){
+			struct cpHastyBatch *b = &batches->arr[j];
+			if(b->num < LANES && !BatchHasBody(b, arb->body_a) && !BatchHasBody(b, arb->body_b)){
+				batch = b;
+				break;
+			}
+		}
+		
+		if(batch == NULL) batch = BatchNew(batches);
+		BatchAdd(batch, arb);
+	}
+	
+	// Point unused lanes at the dummy body.
+	for(int j=0; j<batches->num; j++){
+		struct cpHastyBatch *batch = &batches->arr[j];
+		for(int l=batch->num; l<LANES; l++){
+			batch->a[l] = batch->b[l] = (cpBody *)&BatchDummyBody;
+		}
+	}
+}
+
+static struct cpHastyBatch *
+BatchNew(struct cpHastyBatches *batches)
+{
+	if(batches->num == batches->max){
+		batches->max = (batches->max ? batches->max*2 : 16);
+		batches->arr = (struct cpHastyBatch *)cprealloc(batches->arr, batches->max*sizeof(struct cpHastyBatch));
+	}
+	
+	struct cpHastyBatch *batch = &batches->arr[batches->num++];
+	memset(batch, 0, sizeof(*batch));
+	return batch;
+}
+
+// Copy the accumulated impulses back for caching and the post-solve callbacks.
+static void
+UnbatchArbiters(struct cpHastyBatches *batches)
+{
+	for(int j=0; j<batches->num; j++){
+		struct cpHastyBatch *batch = &batches->arr[j];
+		for(int l=0; l<batch->num; l++){
+			cpArbiter *arb = batch->arbs[l];
+			for(int i=0; i<arb->count; i++){
+				struct cpContact *con = &arb->contacts[i];
+				struct cpHastyContacts *c = &batch->contacts[i];
+				con->jBias = c->jBias[l];
+				con->jnAcc = c->jnAcc[l];
+				con->jtAcc = c->jtAcc[l];
+			}
+		}
+	}
+}
+
+#define GATHER(__dst__, __bodies__, __field__) { \
+	cpFloat __tmp__[LANES]; \
+	for(int l=0; l<LANES; l++) __tmp__[l] = __bodies__[l]->__field__; \
+	__dst__ = vloadN(__tmp__); \
+}
+
+// Only the used lanes are written back.
+#define SCATTER(__src__, __bodies__, __field__) { \
+	cpFloat __tmp__[LANES]; \
+	vstoreN(__tmp__, __src__); \
+	for(int l=0; l<batch->num; l++) __bodies__[l]->__field__ = __tmp__[l]; \
+}
+
+// cpArbiterApplyImpulse() for every lane of a batch.
+static void
+cpArbiterApplyImpulse_Batch(struct cpHastyBatch *batch)
+{
+	cpBody **a = batch->a;
+	cpBody **b = batch->b;
+	cpFloatxN_t v_bias_x_a, v_bias_y_a, w_bias_a, v_x_a, v_y_a, w_a;
+	cpFloatxN_t v_bias_x_b, v_bias_y_b, w_bias_b, v_x_b, v_y_b, w_b;
+	GATHER(v_bias_x_a, a, v_bias.x); GATHER(v_bias_y_a, a, v_bias.y); GATHER(w_bias_a, a, w_bias);
+	GATHER(v_x_a, a, v.x); GATHER(v_y_a, a, v.y); GATHER(w_a, a, w);
+	GATHER(v_bias_x_b, b, v_bias.x); GATHER(v_bias_y_b, b, v_bias.y); GATHER(w_bias_b, b, w_bias);
+	GATHER(v_x_b, b, v.x); GATHER(v_y_b, b, v.y); GATHER(w_b, b, w);
+	
+	cpFloatxN_t nx = vloadN(batch->nx), ny = vloadN(batch->ny);
+	cpFloatxN_t u = vloadN(batch->u);
+	cpFloatxN_t svrx = vloadN(batch->svrx), svry = vloadN(batch->svry);
+	cpFloatxN_t m_inv_a = vloadN(batch->m_inv_a), i_inv_a = vloadN(batch->i_inv_a);
+	cpFloatxN_t m_inv_b = vloadN(batch->m_inv_b), i_inv_b = vloadN(batch->i_inv_b);
+	cpFloatxN_t zero = vdupN(0.0);
+	
+	for(int i=0; i<batch->count; i++){
+		struct cpHastyContacts *c = &batch->contacts[i];
+		cpFloatxN_t r1x = vloadN(c->r1x), r1y = vloadN(c->r1y);
+		cpFloatxN_t r2x = vloadN(c->r2x), r2y = vloadN(c->r2y);
+		
+		cpFloatxN_t vb1x = vsubN(v_bias_x_a, vmulN(r1y, w_bias_a));
+		cpFloatxN_t vb1y = vaddN(v_bias_y_a, vmulN(r1x, w_bias_a));
+		cpFloatxN_t vb2x = vsubN(v_bias_x_b, vmulN(r2y, w_bias_b));
+		cpFloatxN_t vb2y = vaddN(v_bias_y_b, vmulN(r2x, w_bias_b));
+		
+		cpFloatxN_t v1x = vsubN(v_x_a, vmulN(r1y, w_a));
+		cpFloatxN_t v1y = vaddN(v_y_a, vmulN(r1x, w_a));
+		cpFloatxN_t v2x = vsubN(v_x_b, vmulN(r2y, w_b));
+		cpFloatxN_t v2y = vaddN(v_y_b, vmulN(r2x, w_b));
+		cpFloatxN_t vrx = vaddN(vsubN(v2x, v1x), svrx);
+		cpFloatxN_t vry = vaddN(vsubN(v2y, v1y), svry);
+		
+		cpFloatxN_t vbn = vaddN(vmulN(vsubN(vb2x, vb1x), nx), vmulN(vsubN(vb2y, vb1y), ny));
+		cpFloatxN_t vrn = vaddN(vmulN(vrx, nx), vmulN(vry, ny));
+		cpFloatxN_t vrt = vaddN(vmulN(vrx, vsubN(zero, ny)), vmulN(vry, nx));
+		
+		cpFloatxN_t nMass = vloadN(c->nMass);
+		cpFloatxN_t jbn = vmulN(vsubN(vloadN(c->bias), vbn), nMass);
+		cpFloatxN_t jbnOld = vloadN(c->jBias);
+		cpFloatxN_t jBias = vmaxN(vaddN(jbnOld, jbn), zero);
+		
+		cpFloatxN_t jn = vmulN(vsubN(zero, vaddN(vloadN(c->bounce), vrn)), nMass);
+		cpFloatxN_t jnOld = vloadN(c->jnAcc);
+		cpFloatxN_t jnAcc = vmaxN(vaddN(jnOld, jn), zero);
+		
+		cpFloatxN_t jtMax = vmulN(u, jnAcc);
+		cpFloatxN_t jt = vmulN(vsubN(zero, vrt), vloadN(c->tMass));
+		cpFloatxN_t jtOld = vloadN(c->jtAcc);
+		cpFloatxN_t jtAcc = vminN(vmaxN(vaddN(jtOld, jt), vsubN(zero, jtMax)), jtMax);
+		
+		vstoreN(c->jBias, jBias);
+		vstoreN(c->jnAcc, jnAcc);
+		vstoreN(c->jtAcc, jtAcc);
+		
+		cpFloatxN_t djb = vsubN(jBias, jbnOld);
+		cpFloatxN_t jbx = vmulN(nx, djb);
+		cpFloatxN_t jby = vmulN(ny, djb);
+		cpFloatxN_t djn = vsubN(jnAcc, jnOld);
+		cpFloatxN_t djt = vsubN(jtAcc, jtOld);
+		cpFloatxN_t jx = vsubN(vmulN(nx, djn), vmulN(ny, djt));
+		cpFloatxN_t jy = vaddN(vmulN(nx, djt), vmulN(ny, djn));
+		
+		v_bias_x_a = vsubN(v_bias_x_a, vmulN(jbx, m_inv_a));
+		v_bias_y_a = vsubN(v_bias_y_a, vmulN(jby, m_inv_a));
+		w_bias_a = vsubN(w_bias_a, vmulN(i_inv_a, vsubN(vmulN(r1x, jby), vmulN(r1y, jbx))));
+		v_bias_x_b = vaddN(v_bias_x_b, vmulN(jbx, m_inv_b));
+		v_bias_y_b = vaddN(v_bias_y_b, vmulN(jby, m_inv_b));
+		w_bias_b = vaddN(w_bias_b, vmulN(i_inv_b, vsubN(vmulN(r2x, jby), vmulN(r2y, jbx))));
+		
+		v_x_a = vsubN(v_x_a, vmulN(jx, m_inv_a));
+		v_y_a = vsubN(v_y_a, vmulN(jy, m_inv_a));
+		w_a = vsubN(w_a, vmulN(i_inv_a, vsubN(vmulN(r1x, jy), vmulN(r1y, jx))));
+		v_x_b = vaddN(v_x_b, vmulN(jx, m_inv_b));
+		v_y_b = vaddN(v_y_b, vmulN(jy, m_inv_b));
+		w_b = vaddN(w_b, vmulN(i_inv_b, vsubN(vmulN(r2x, jy), vmulN(r2y, jx))));
+	}
+	
+	SCATTER(v_bias_x_a, a, v_bias.x); SCATTER(v_bias_y_a, a, v_bias.y); SCATTER(w_bias_a, a, w_bias);
+	SCATTER(v_x_a, a, v.x); SCATTER(v_y_a, a, v.y); SCATTER(w_a, a, w);
+	SCATTER(v_bias_x_b, b, v_bias.x); SCATTER(v_bias_y_b, b, v_bias.y); SCATTER(w_bias_b, b, w_bias);
+	SCATTER(v_x_b, b, v.x); SCATTER(v_y_b, b, v.y); SCATTER(w_b, b, w);
+}
+
+#endif
+
 //MARK: PThreads
 
-// Right now using more than 2 threads probably wont help your performance any.
-// If you are using a ridiculous number of iterations it could help though.
-#define MAX_THREADS 2
+// Each thread runs a share of the solver iterations over all of the constraints,
+// so more threads only help with a large number of iterations.
+#define MAX_THREADS 8
 
 struct ThreadContext {
 	pthread_t thread;
@@ -205,6 +492,11 @@ struct cpHastySpace {
 	cpHastySpaceWorkFunction work;
 	
 	struct ThreadContext workers[MAX_THREADS - 1];
+	
+#if CP_HASTY_BATCHED
+	// Arbiters packed for the batched solver, rebuilt every step.
+	struct cpHastyBatches batches;
+#endif
 };
 
 static void *
@@ -264,12 +556,20 @@ static void
 Solver(cpSpace *space, unsigned long worker, unsigned long worker_count)
 {
 	cpArray *constraints = space->constraints;
+#if !CP_HASTY_BATCHED
 	cpArray *arbiters = space->arbiters;
+#endif
 	
 	cpFloat dt = space->curr_dt;
 	unsigned long iterations = (space->iterations + worker_count - 1)/worker_count;
 	
 	for(unsigned long i=0; i<iterations; i++){
+	#if CP_HASTY_BATCHED
+		struct cpHastyBatches *batches = &((cpHastySpace *)space)->batches;
+		for(int j=0; j<batches->num; j++){
+			cpArbiterApplyImpulse_Batch(&batches->arr[j]);
+		}
+	#else
 		for(int j=0; j<arbiters->num; j++){
 			cpArbiter *arb = (cpArbiter *)arbiters->arr[j];
 			#ifdef __ARM_NEON__
@@ -278,6 +578,7 @@ Solver(cpSpace *space, unsigned long worker, unsigned long worker_count)
 				cpArbiterApplyImpulse(arb);
 			#endif
 		}
+	#endif
 			
 		for(int j=0; j<constraints->num; j++){
 			cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
@@ -320,7 +621,10 @@ cpHastySpaceSetThreads(cpSpace *space, unsigned long threads)
 		sysctlbyname("hw.ncpu", &threads, &size, NULL, 0);
 	}
 #else
-	if(threads == 0) threads = 1;
+	if(threads == 0){
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (cpus > 0 ? (unsigned long)cpus : 1);
+	}
 #endif
 	
 	hasty->num_threads = (threads < MAX_THREADS ? threads : MAX_THREADS);
@@ -380,6 +684,10 @@ cpHastySpaceFree(cpSpace *space)
 	pthread_cond_destroy(&hasty->cond_work);
 	pthread_cond_destroy(&hasty->cond_resume);
 	
+#if CP_HASTY_BATCHED
+	cpfree(hasty->batches.arr);
+#endif
+	
 	cpSpaceFree(space);
 }
 
@@ -389,6 +697,7 @@ cpHastySpaceStep(cpSpace *space, cpFloat dt)
 	// don't step if the timestep is 0!
 	if(dt == 0.0f) return;
 	
+	cpTraceBegin("cpSpaceStep");
 	space->stamp++;
 	
 	cpFloat prev_dt = space->curr_dt;
@@ -412,25 +721,34 @@ cpHastySpaceStep(cpSpace *space, cpFloat dt)
 
 	cpSpaceLock(space); {
 		// Integrate positions
+		cpTraceBegin("integrate positions");
 		for(int i=0; i<bodies->num; i++){
 			cpBody *body = (cpBody *)bodies->arr[i];
 			body->position_func(body, dt);
 		}
+		cpTraceEnd("integrate positions");
 		
 		// Find colliding pairs.
+		cpTraceBegin("collide");
 		cpSpacePushFreshContactBuffer(space);
 		cpSpatialIndexEach(space->dynamicShapes, (cpSpatialIndexIteratorFunc)cpShapeUpdateFunc, NULL);
 		cpSpatialIndexReindexQuery(space->dynamicShapes, (cpSpatialIndexQueryFunc)cpSpaceCollideShapes, space);
+		cpTraceEnd("collide");
 	} cpSpaceUnlock(space, cpFalse);
 	
 	// Rebuild the contact graph (and detect sleeping components if sleeping is enabled)
+	cpTraceBegin("process components");
 	cpSpaceProcessComponents(space, dt);
+	cpTraceEnd("process components");
 	
 	cpSpaceLock(space); {
 		// Clear out old cached arbiters and call separate callbacks
+		cpTraceBegin("filter arbiters");
 		cpHashSetFilter(space->cachedArbiters, (cpHashSetFilterFunc)cpSpaceArbiterSetFilter, space);
+		cpTraceEnd("filter arbiters");
 
 		// Prestep the arbiters and constraints.
+		cpTraceBegin("prestep");
 		cpFloat slop = space->collisionSlop;
 		cpFloat biasCoef = 1.0f - cpfpow(space->collisionBias, dt);
 		for(int i=0; i<arbiters->num; i++){
@@ -445,16 +763,20 @@ cpHastySpaceStep(cpSpace *space, cpFloat dt)
 			
 			constraint->klass->preStep(constraint, dt);
 		}
+		cpTraceEnd("prestep");
 	
 		// Integrate velocities.
+		cpTraceBegin("integrate velocities");
 		cpFloat damping = cpfpow(space->damping, dt);
 		cpVect gravity = space->gravity;
 		for(int i=0; i<bodies->num; i++){
 			cpBody *body = (cpBody *)bodies->arr[i];
 			body->velocity_func(body, gravity, damping, dt);
 		}
+		cpTraceEnd("integrate velocities");
 		
 		// Apply cached impulses
+		cpTraceBegin("apply cached impulses");
 		cpFloat dt_coef = (prev_dt == 0.0f ? 0.0f : dt/prev_dt);
 		for(int i=0; i<arbiters->num; i++){
 			cpArbiterApplyCachedImpulse((cpArbiter *)arbiters->arr[i], dt_coef);
@@ -464,16 +786,26 @@ cpHastySpaceStep(cpSpace *space, cpFloat dt)
 			cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
 			constraint->klass->applyCachedImpulse(constraint, dt_coef);
 		}
+		cpTraceEnd("apply cached impulses");
 		
 		// Run the impulse solver.
+		cpTraceBegin("solve");
 		cpHastySpace *hasty = (cpHastySpace *)space;
+	#if CP_HASTY_BATCHED
+		BatchArbiters(&hasty->batches, arbiters);
+	#endif
 		if((unsigned long)(arbiters->num + constraints->num) > hasty->constraint_count_threshold){
 			RunWorkers(hasty, Solver);
 		} else {
 			Solver(space, 0, 1);
 		}
+	#if CP_HASTY_BATCHED
+		UnbatchArbiters(&hasty->batches);
+	#endif
+		cpTraceEnd("solve");
 		
 		// Run the constraint post-solve callbacks
+		cpTraceBegin("post-solve callbacks");
 		for(int i=0; i<constraints->num; i++){
 			cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
 			
@@ -488,5 +820,7 @@ cpHastySpaceStep(cpSpace *space, cpFloat dt)
 			cpCollisionHandler *handler = arb->handler;
 			handler->postSolveFunc(arb, space, handler->userData);
 		}
+		cpTraceEnd("post-solve callbacks");
 	} cpSpaceUnlock(space, cpTrue);
+	cpTraceEnd("cpSpaceStep");
 }
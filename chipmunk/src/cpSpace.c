@@ -705,3 +705,19 @@ cpSpaceUseSpatialHash(cpSpace *space, cpFloat dim, int count)
 	space->staticShapes = staticShapes;
 	space->dynamicShapes = dynamicShapes;
 }
+
+void
+cpSpaceUseSweepY(cpSpace *space)
+{
+	cpSpatialIndex *staticShapes = cpSweepYNew((cpSpatialIndexBBFunc)cpShapeGetBB, NULL);
+	cpSpatialIndex *dynamicShapes = cpSweepYNew((cpSpatialIndexBBFunc)cpShapeGetBB, staticShapes);
+	
+	cpSpatialIndexEach(space->staticShapes, (cpSpatialIndexIteratorFunc)copyShapes, staticShapes);
+	cpSpatialIndexEach(space->dynamicShapes, (cpSpatialIndexIteratorFunc)copyShapes, dynamicShapes);
+	
+	cpSpatialIndexFree(space->staticShapes);
+	cpSpatialIndexFree(space->dynamicShapes);
+	
+	space->staticShapes = staticShapes;
+	space->dynamicShapes = dynamicShapes;
+}
@@ -341,6 +341,7 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 	// don't step if the timestep is 0!
 	if(dt == 0.0f) return;
 	
+	cpTraceBegin("cpSpaceStep");
 	space->stamp++;
 	
 	cpFloat prev_dt = space->curr_dt;
@@ -364,25 +365,34 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 
 	cpSpaceLock(space); {
 		// Integrate positions
+		cpTraceBegin("integrate positions");
 		for(int i=0; i<bodies->num; i++){
 			cpBody *body = (cpBody *)bodies->arr[i];
 			body->position_func(body, dt);
 		}
+		cpTraceEnd("integrate positions");
 		
 		// Find colliding pairs.
+		cpTraceBegin("collide");
 		cpSpacePushFreshContactBuffer(space);
 		cpSpatialIndexEach(space->dynamicShapes, (cpSpatialIndexIteratorFunc)cpShapeUpdateFunc, NULL);
 		cpSpatialIndexReindexQuery(space->dynamicShapes, (cpSpatialIndexQueryFunc)cpSpaceCollideShapes, space);
+		cpTraceEnd("collide");
 	} cpSpaceUnlock(space, cpFalse);
 	
 	// Rebuild the contact graph (and detect sleeping components if sleeping is enabled)
+	cpTraceBegin("process components");
 	cpSpaceProcessComponents(space, dt);
+	cpTraceEnd("process components");
 	
 	cpSpaceLock(space); {
 		// Clear out old cached arbiters and call separate callbacks
+		cpTraceBegin("filter arbiters");
 		cpHashSetFilter(space->cachedArbiters, (cpHashSetFilterFunc)cpSpaceArbiterSetFilter, space);
+		cpTraceEnd("filter arbiters");
 
 		// Prestep the arbiters and constraints.
+		cpTraceBegin("prestep");
 		cpFloat slop = space->collisionSlop;
 		cpFloat biasCoef = 1.0f - cpfpow(space->collisionBias, dt);
 		for(int i=0; i<arbiters->num; i++){
@@ -397,16 +407,20 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 			
 			constraint->klass->preStep(constraint, dt);
 		}
+		cpTraceEnd("prestep");
 	
 		// Integrate velocities.
+		cpTraceBegin("integrate velocities");
 		cpFloat damping = cpfpow(space->damping, dt);
 		cpVect gravity = space->gravity;
 		for(int i=0; i<bodies->num; i++){
 			cpBody *body = (cpBody *)bodies->arr[i];
 			body->velocity_func(body, gravity, damping, dt);
 		}
+		cpTraceEnd("integrate velocities");
 		
 		// Apply cached impulses
+		cpTraceBegin("apply cached impulses");
 		cpFloat dt_coef = (prev_dt == 0.0f ? 0.0f : dt/prev_dt);
 		for(int i=0; i<arbiters->num; i++){
 			cpArbiterApplyCachedImpulse((cpArbiter *)arbiters->arr[i], dt_coef);
@@ -416,8 +430,29 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 			cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
 			constraint->klass->applyCachedImpulse(constraint, dt_coef);
 		}
+		cpTraceEnd("apply cached impulses");
 		
 		// Run the impulse solver.
+		cpTraceBegin("solve");
+#if CP_FIXED_SOLVER
+		// Constraints solve on the cpFloat velocities, so they need the
+		// cpFloat solver alongside them.
+		if(constraints->num == 0){
+			for(int i=0; i<arbiters->num; i++){
+				cpArbiterToFixed((cpArbiter *)arbiters->arr[i]);
+			}
+			
+			for(int i=0; i<space->iterations; i++){
+				for(int j=0; j<arbiters->num; j++){
+					cpArbiterApplyImpulseFixed((cpArbiter *)arbiters->arr[j]);
+				}
+			}
+			
+			for(int i=0; i<arbiters->num; i++){
+				cpArbiterFromFixed((cpArbiter *)arbiters->arr[i]);
+			}
+		} else
+#endif
 		for(int i=0; i<space->iterations; i++){
 			for(int j=0; j<arbiters->num; j++){
 				cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j]);
@@ -428,8 +463,10 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 				constraint->klass->applyImpulse(constraint, dt);
 			}
 		}
+		cpTraceEnd("solve");
 		
 		// Run the constraint post-solve callbacks
+		cpTraceBegin("post-solve callbacks");
 		for(int i=0; i<constraints->num; i++){
 			cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
 			
@@ -444,5 +481,7 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 			cpCollisionHandler *handler = arb->handler;
 			handler->postSolveFunc(arb, space, handler->userData);
 		}
+		cpTraceEnd("post-solve callbacks");
 	} cpSpaceUnlock(space, cpTrue);
+	cpTraceEnd("cpSpaceStep");
 }
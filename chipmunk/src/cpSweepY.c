@@ -0,0 +1,273 @@
+#include <string.h>
+
+#include "chipmunk/chipmunk_private.h"
+
+// Sort and sweep along the y axis, for worlds that are much taller than they are wide.
+// Unlike cpSweep1D the table is kept sorted between steps, by insertion sort so that
+// the mostly unchanged order from the last step costs next to nothing to restore.
+// Being sorted, rectangle queries only need to look at the cells that can reach them.
+
+static inline cpSpatialIndexClass *Klass();
+
+//MARK: Basic Structures
+
+typedef struct TableCell {
+	void *obj;
+	cpBB bb;
+} TableCell;
+
+struct cpSweepY
+{
+	cpSpatialIndex spatialIndex;
+
+	int num;
+	int max;
+	TableCell *table;
+
+	// Tallest cell since the last full reindex, bounding how far below a query to look.
+	cpFloat maxHeight;
+};
+
+static inline cpBool
+OverlapX(cpBB a, cpBB b)
+{
+	return (a.l <= b.r && b.l <= a.r);
+}
+
+static inline TableCell
+MakeTableCell(cpSweepY *sweep, void *obj)
+{
+	TableCell cell = {obj, sweep->spatialIndex.bbfunc(obj)};
+	sweep->maxHeight = cpfmax(sweep->maxHeight, cell.bb.t - cell.bb.b);
+	return cell;
+}
+
+// Move table[i] down until the table is sorted by the bottom edge again.
+static inline void
+SiftDown(TableCell *table, int i)
+{
+	TableCell cell = table[i];
+	for(; i > 0 && table[i - 1].bb.b > cell.bb.b; i--) table[i] = table[i - 1];
+	table[i] = cell;
+}
+
+// Move table[i] up until the table is sorted by the bottom edge again.
+static inline void
+SiftUp(TableCell *table, int count, int i)
+{
+	TableCell cell = table[i];
+	for(; i < count - 1 && table[i + 1].bb.b < cell.bb.b; i++) table[i] = table[i + 1];
+	table[i] = cell;
+}
+
+// Index of the first cell starting above y.
+static int
+UpperBound(cpSweepY *sweep, cpFloat y)
+{
+	TableCell *table = sweep->table;
+	int lo = 0, hi = sweep->num;
+	while(lo < hi){
+		int mid = (lo + hi)/2;
+		if(table[mid].bb.b <= y){
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+//MARK: Memory Management Functions
+
+cpSweepY *
+cpSweepYAlloc(void)
+{
+	return (cpSweepY *)cpcalloc(1, sizeof(cpSweepY));
+}
+
+static void
+ResizeTable(cpSweepY *sweep, int size)
+{
+	sweep->max = size;
+	sweep->table = (TableCell *)cprealloc(sweep->table, size*sizeof(TableCell));
+}
+
+cpSpatialIndex *
+cpSweepYInit(cpSweepY *sweep, cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex)
+{
+	cpSpatialIndexInit((cpSpatialIndex *)sweep, Klass(), bbfunc, staticIndex);
+
+	sweep->num = 0;
+	sweep->maxHeight = 0.0f;
+	ResizeTable(sweep, 32);
+
+	return (cpSpatialIndex *)sweep;
+}
+
+cpSpatialIndex *
+cpSweepYNew(cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex)
+{
+	return cpSweepYInit(cpSweepYAlloc(), bbfunc, staticIndex);
+}
+
+static void
+cpSweepYDestroy(cpSweepY *sweep)
+{
+	cpfree(sweep->table);
+	sweep->table = NULL;
+}
+
+//MARK: Misc
+
+static int
+cpSweepYCount(cpSweepY *sweep)
+{
+	return sweep->num;
+}
+
+static void
+cpSweepYEach(cpSweepY *sweep, cpSpatialIndexIteratorFunc func, void *data)
+{
+	TableCell *table = sweep->table;
+	for(int i=0, count=sweep->num; i<count; i++) func(table[i].obj, data);
+}
+
+static int
+cpSweepYFind(cpSweepY *sweep, void *obj)
+{
+	TableCell *table = sweep->table;
+	for(int i=0, count=sweep->num; i<count; i++){
+		if(table[i].obj == obj) return i;
+	}
+
+	return -1;
+}
+
+static cpBool
+cpSweepYContains(cpSweepY *sweep, void *obj, cpHashValue hashid)
+{
+	return (cpSweepYFind(sweep, obj) >= 0);
+}
+
+//MARK: Basic Operations
+
+static void
+cpSweepYInsert(cpSweepY *sweep, void *obj, cpHashValue hashid)
+{
+	if(sweep->num == sweep->max) ResizeTable(sweep, sweep->max*2);
+
+	sweep->table[sweep->num] = MakeTableCell(sweep, obj);
+	sweep->num++;
+	SiftDown(sweep->table, sweep->num - 1);
+}
+
+static void
+cpSweepYRemove(cpSweepY *sweep, void *obj, cpHashValue hashid)
+{
+	int i = cpSweepYFind(sweep, obj);
+	if(i < 0) return;
+
+	// Close the gap, keeping the table sorted.
+	int num = --sweep->num;
+	memmove(sweep->table + i, sweep->table + i + 1, (num - i)*sizeof(TableCell));
+	sweep->table[num].obj = NULL;
+}
+
+//MARK: Reindexing Functions
+
+static void
+cpSweepYReindexObject(cpSweepY *sweep, void *obj, cpHashValue hashid)
+{
+	int i = cpSweepYFind(sweep, obj);
+	if(i < 0) return;
+
+	sweep->table[i] = MakeTableCell(sweep, obj);
+	SiftDown(sweep->table, i);
+	SiftUp(sweep->table, sweep->num, i);
+}
+
+static void
+cpSweepYReindex(cpSweepY *sweep)
+{
+	TableCell *table = sweep->table;
+	int count = sweep->num;
+
+	sweep->maxHeight = 0.0f;
+	for(int i=0; i<count; i++){
+		table[i] = MakeTableCell(sweep, table[i].obj);
+		SiftDown(table, i);
+	}
+}
+
+//MARK: Query Functions
+
+static void
+cpSweepYQuery(cpSweepY *sweep, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data)
+{
+	TableCell *table = sweep->table;
+
+	// Cells starting above the query can't touch it, and nor can cells
+	// starting so far below it that even the tallest cell falls short.
+	cpFloat lowest = bb.b - sweep->maxHeight;
+	for(int i=UpperBound(sweep, bb.t) - 1; i>=0 && table[i].bb.b >= lowest; i--){
+		TableCell cell = table[i];
+		if(cell.bb.t >= bb.b && OverlapX(bb, cell.bb) && obj != cell.obj) func(obj, cell.obj, 0, data);
+	}
+}
+
+static void
+cpSweepYSegmentQuery(cpSweepY *sweep, void *obj, cpVect a, cpVect b, cpFloat t_exit, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	cpBB bb = cpBBExpand(cpBBNew(a.x, a.y, a.x, a.y), b);
+	TableCell *table = sweep->table;
+
+	cpFloat lowest = bb.b - sweep->maxHeight;
+	for(int i=UpperBound(sweep, bb.t) - 1; i>=0 && table[i].bb.b >= lowest; i--){
+		TableCell cell = table[i];
+		if(cell.bb.t >= bb.b && OverlapX(bb, cell.bb)) func(obj, cell.obj, data);
+	}
+}
+
+//MARK: Reindex/Query
+
+static void
+cpSweepYReindexQuery(cpSweepY *sweep, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpSweepYReindex(sweep);
+
+	TableCell *table = sweep->table;
+	int count = sweep->num;
+	for(int i=0; i<count; i++){
+		TableCell cell = table[i];
+		cpFloat max = cell.bb.t;
+
+		for(int j=i+1; j<count && table[j].bb.b <= max; j++){
+			if(OverlapX(cell.bb, table[j].bb)) func(cell.obj, table[j].obj, 0, data);
+		}
+	}
+
+	// Reindex query is also responsible for colliding against the static index.
+	// Fortunately there is a helper function for that.
+	cpSpatialIndexCollideStatic((cpSpatialIndex *)sweep, sweep->spatialIndex.staticIndex, func, data);
+}
+
+static cpSpatialIndexClass klass = {
+	(cpSpatialIndexDestroyImpl)cpSweepYDestroy,
+
+	(cpSpatialIndexCountImpl)cpSweepYCount,
+	(cpSpatialIndexEachImpl)cpSweepYEach,
+	(cpSpatialIndexContainsImpl)cpSweepYContains,
+
+	(cpSpatialIndexInsertImpl)cpSweepYInsert,
+	(cpSpatialIndexRemoveImpl)cpSweepYRemove,
+
+	(cpSpatialIndexReindexImpl)cpSweepYReindex,
+	(cpSpatialIndexReindexObjectImpl)cpSweepYReindexObject,
+	(cpSpatialIndexReindexQueryImpl)cpSweepYReindexQuery,
+
+	(cpSpatialIndexQueryImpl)cpSweepYQuery,
+	(cpSpatialIndexSegmentQueryImpl)cpSweepYSegmentQuery,
+};
+
+static inline cpSpatialIndexClass *Klass(){return &klass;}
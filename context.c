@@ -0,0 +1,38 @@
+#include "context.h"
+
+#include <string.h>
+
+#include "pickup.h"
+
+
+// The displayed game, set up by Initialize
+static GameContext mainContext =
+{
+	.PlayerState = { .Count = DEFAULT_PLAYERS }
+};
+THREAD_LOCAL GameContext *Game = &mainContext;
+
+
+void GameContextInit(GameContext *c, const int numPlayers, const bool headless)
+{
+	memset(c, 0, sizeof *c);
+	c->PlayerState.Count = numPlayers;
+	c->Offscreen = true;
+	c->Headless = headless;
+	// The init functions work on the current context
+	GameContext *prev = Game;
+	Game = c;
+	PickupsInit();
+	// Solve on this thread only; contexts are run side by side instead
+	SpaceInit(&c->Space, 0, PhysicsIndex);
+	c->Particles.Count = 0;
+	Game = prev;
+}
+void GameContextFree(GameContext *c)
+{
+	GameContext *prev = Game;
+	Game = c;
+	PickupsFree();
+	SpaceFree(&c->Space);
+	Game = prev;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "c_array.h"
+#include "camera.h"
+#include "main.h"
+#include "particle.h"
+#include "player.h"
+#include "replay.h"
+#include "rng.h"
+#include "space.h"
+#include "title.h"
+#include "utils.h"
+
+// How a game went, filled in as it ends
+typedef struct
+{
+	// Game time from the start until every player was out
+	uint32_t Ms;
+	int NumPlayers;
+	int Scores[MAX_PLAYERS];
+	int MaxScore;
+} GameResult;
+
+// Everything that changes as a game is played. Each thread works on its own
+// current context, so that several games can be simulated side by side;
+// assets, options and the display are shared.
+typedef struct
+{
+	Space Space;
+	Camera Camera;
+	PlayerState PlayerState;
+	Player Players[MAX_PLAYERS];
+	ParticlePool Particles;
+	CArray Pickups;	// of Pickup
+	Rng Rngs[RNG_COUNT];
+
+	// Handlers of the current screen
+	TGatherInput GatherInput;
+	TDoLogic DoLogic;
+	TOutputFrame OutputFrame;
+
+	TitleState Title;
+
+	// Games that are never displayed skip purely visual effects
+	bool Offscreen;
+	// Games without video, audio or controls: bots play, nothing is heard,
+	// and results stay out of the high scores
+	bool Headless;
+	// Seed for new games; 0 to seed them from the clock
+	uint32_t Seed;
+	bool Pause;
+	// Inputs of the current frame, for recording and playback
+	ReplayFrame Input;
+	// Time into the current game
+	uint32_t GameMs;
+	// Number of games that have ended, and how the last one went
+	int GamesOver;
+	GameResult LastResult;
+} GameContext;
+
+// The context of the game on this thread; the main thread starts with the
+// one that is displayed
+extern THREAD_LOCAL GameContext *Game;
+
+// Set up an offscreen context with the given number of players
+void GameContextInit(GameContext *c, const int numPlayers, const bool headless);
+void GameContextFree(GameContext *c);
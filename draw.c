@@ -3,6 +3,8 @@
 
 #include "SDL.h"
 
+#include "draw.h"
+
 /*
  * SDL_Surface 32-bit circle-fill algorithm without using trig
  *
@@ -67,4 +69,11 @@ void DRAW_FillCircle(SDL_Surface *surface, int cx, int cy, int radius, Uint32 pi
 	}
 	if (SDL_MUSTLOCK(surface))
 		SDL_UnlockSurface(surface);
-}
\ No newline at end of file
+}
+
+void DRAW_Sprite(const DrawSprite *sprite, SDL_Surface *surface, const int y)
+{
+	SDL_Rect src = sprite->Src;
+	SDL_Rect dest = { (Sint16)sprite->X, (Sint16)(sprite->Y - y), 0, 0 };
+	SDL_BlitSurface(sprite->Surface, &src, surface, &dest);
+}
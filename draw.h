@@ -5,4 +5,17 @@
 
 extern void DRAW_FillCircle(SDL_Surface *surface, int cx, int cy, int radius, Uint32 pixel);
 
+/*
+ * A part of a surface and where to blit it, before scrolling up by the
+ * camera's screen Y
+ */
+typedef struct
+{
+	SDL_Surface *Surface;
+	SDL_Rect Src;
+	int X, Y;
+} DrawSprite;
+
+extern void DRAW_Sprite(const DrawSprite *sprite, SDL_Surface *surface, const int y);
+
 #endif /* !defined(_DRAW_H_) */
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Q16.16 fixed point, for builds without an FPU (FIXED_POINT_DRAW), where
+// every float operation is a slow library call. Conversions from and to
+// float work on the bits of the float, so they need no float operations
+// either. Field coordinates fit for hours of play.
+
+typedef int32_t Fixed;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE (1 << FIXED_SHIFT)
+// For constant expressions only, which the compiler folds
+#define FIXED_CONST(_x) ((Fixed)((_x) * FIXED_ONE + ((_x) < 0 ? -0.5 : 0.5)))
+
+static inline Fixed FixedMul(const Fixed a, const Fixed b)
+{
+	return (Fixed)(((int64_t)a * b) >> FIXED_SHIFT);
+}
+
+// Truncates toward zero, and saturates beyond the range
+static inline Fixed FixedFromFloat(const float f)
+{
+	uint32_t u;
+	memcpy(&u, &f, sizeof u);
+	const int exponent = (int)((u >> 23) & 0xff) - 127;
+	// Below the smallest step; also zero and denormals
+	if (exponent < -FIXED_SHIFT - 1) return 0;
+	const uint32_t mantissa = (u & 0x7fffff) | 0x800000;
+	// The float is mantissa * 2^(exponent - 23); shift that to Q16.16
+	const int shift = exponent - 23 + FIXED_SHIFT;
+	int32_t v;
+	if (shift > 30 - 23)
+	{
+		v = INT32_MAX;
+	}
+	else if (shift >= 0)
+	{
+		v = (int32_t)(mantissa << shift);
+	}
+	else
+	{
+		v = (int32_t)(mantissa >> -shift);
+	}
+	return (u >> 31) ? -v : v;
+}
+
+static inline float FixedToFloat(const Fixed x)
+{
+	if (x == 0) return 0;
+	uint32_t m = x < 0 ? -(uint32_t)x : (uint32_t)x;
+	// Position of the leading one
+#ifdef __GNUC__
+	const int top = 31 - __builtin_clz(m);
+#else
+	int top = 31;
+	while (!(m & (1u << top))) top--;
+#endif
+	// Normalise to 24 bits, truncating
+	if (top > 23) m >>= top - 23;
+	else m <<= 23 - top;
+	const uint32_t u =
+		(x < 0 ? 0x80000000u : 0) |
+		((uint32_t)(top - FIXED_SHIFT + 127) << 23) |
+		(m & 0x7fffff);
+	float f;
+	memcpy(&f, &u, sizeof f);
+	return f;
+}
@@ -20,13 +20,17 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 #include <math.h>
+#include <time.h>
 
 #include <SDL.h>
 
+#include "bot.h"
 #include "camera.h"
+#include "context.h"
 #include "main.h"
 #include "init.h"
 #include "input.h"
@@ -34,6 +38,10 @@
 #include "pickup.h"
 #include "platform.h"
 #include "player.h"
+#include "profiler.h"
+#include "render.h"
+#include "replay.h"
+#include "rng.h"
 #include "sound.h"
 #include "space.h"
 #include "title.h"
@@ -43,65 +51,126 @@
 #include "draw.h"
 #include "bg.h"
 
-static bool                   Pause;
-
 Mix_Chunk* SoundBeep = NULL;
 Mix_Chunk* SoundStart = NULL;
 Mix_Chunk* SoundLose = NULL;
 Mix_Chunk* SoundScore = NULL;
 
 TTF_Font *font = NULL;
+TextAtlas fontAtlas;
 
 
+static void RecordFrame(const Uint32 ms);
 void GameGatherInput(bool* Continue)
 {
 	SDL_Event ev;
 
-	while (SDL_PollEvent(&ev))
+	while (RenderPollEvent(&ev))
 	{
 		InputOnEvent(&ev);
 		if (IsPauseEvent(&ev))
-			Pause = !Pause;
+		{
+			Game->Pause = !Game->Pause;
+			Game->Input.Pause = !Game->Input.Pause;
+		}
+		else if (IsProfilerToggleEvent(&ev))
+			ProfilerToggle();
 		else if (IsExitGameEvent(&ev))
 		{
 			*Continue = false;
+			Game->Input.Exit = true;
+			RecordFrame(0);
 			return;
 		}
 	}
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	PlayerState *ps = &Game->PlayerState;
+	for (int i = 0; i < ps->Count; i++)
+	{
+		if (!ps->Alive[i]) continue;
+		ps->AccelX[i] = i < MAX_HUMAN_PLAYERS ?
+			GetMovement(i) : BotGetMovement(&Game->Players[i]);
+	}
+}
+
+// Play back inputs from a recording instead of the controls
+void GameReplayGatherInput(bool* Continue)
+{
+	if (!Game->Headless)
+	{
+		// Still allow quitting while watching
+		SDL_Event ev;
+		while (RenderPollEvent(&ev))
+		{
+			if (IsExitGameEvent(&ev))
+			{
+				*Continue = false;
+				return;
+			}
+		}
+	}
+	if (!ReplayPlayFrame(&replay, &Game->Input) || Game->Input.Exit)
 	{
-		if (!players[i].Alive) continue;
-		players[i].AccelX = GetMovement(i);
+		*Continue = false;
+		return;
 	}
+	if (Game->Input.Pause)
+		Game->Pause = !Game->Pause;
+	memcpy(
+		Game->PlayerState.AccelX, Game->Input.AccelX,
+		Game->PlayerState.Count * sizeof Game->Input.AccelX[0]);
+}
+
+static void RecordFrame(const Uint32 ms)
+{
+	if (replay.Mode != REPLAY_MODE_RECORD) return;
+	memcpy(
+		Game->Input.AccelX, Game->PlayerState.AccelX,
+		Game->PlayerState.Count * sizeof Game->Input.AccelX[0]);
+	Game->Input.Ms = ms;
+	ReplayRecordFrame(&replay, &Game->Input);
+	Game->Input.Pause = false;
 }
 
-static float PlayerMiddleY(void);
-static float PlayerMinY(void);
-static float PlayerMaxY(void);
 void GameDoLogic(bool* Continue, bool* Error, Uint32 Milliseconds)
 {
 	(void)Continue;
 	(void)Error;
-	if (Pause) return;
+	if (replay.Mode == REPLAY_MODE_PLAY)
+	{
+		// Step by the recorded frame time
+		Milliseconds = Game->Input.Ms;
+	}
+	else
+	{
+		RecordFrame(Milliseconds);
+	}
+	if (Game->Pause) return;
+	Game->GameMs += Milliseconds;
 
-	cpSpaceStep(space.Space, Milliseconds * 0.001);
-	CameraUpdate(&camera, PlayerMiddleY(), Milliseconds);
+	ProfilerBegin(PROFILER_PHYSICS);
+	SpaceStep(&Game->Space, Milliseconds * 0.001);
+	ProfilerEnd(PROFILER_PHYSICS);
+	PlayersSync();
+	CameraUpdate(&Game->Camera, PlayersGetSummary()->MiddleY, Milliseconds);
 
+	PlayerState *ps = &Game->PlayerState;
 	bool hasPlayers = false;
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < ps->Count; i++)
 	{
-		Player *p = &players[i];
-		if (!p->Enabled) continue;
+		Player *p = &Game->Players[i];
+		if (!ps->Enabled[i]) continue;
+		ProfilerBegin(PROFILER_PLAYERS);
 		PlayerUpdate(p, Milliseconds);
+		ProfilerEnd(PROFILER_PLAYERS);
 		// Check if the player needs to be respawned
-		if (p->RespawnCounter == 0 && !p->Alive && space.Gaps.size > 0)
+		if (p->RespawnCounter == 0 && !ps->Alive[i] && Game->Space.NumGaps > 0)
 		{
-			SpaceRespawnPlayer(&space, p);
+			SpaceRespawnPlayer(&Game->Space, p);
 		}
-		if (!p->Alive)
+		if (!ps->Alive[i])
 		{
 			// Check if any players are past ones that await reenabling
-			if (p->RespawnCounter == -1 && PlayerMinY() < p->y)
+			if (p->RespawnCounter == -1 && PlayersGetSummary()->EnabledMinY < ps->Y[i])
 			{
 				PlayerRevive(p);
 			}
@@ -113,14 +182,13 @@ void GameDoLogic(bool* Continue, bool* Error, Uint32 Milliseconds)
 		hasPlayers = true;
 
 		// Check player pickups
-		if (PickupsCollide(p->x, p->y, PLAYER_RADIUS))
+		if (PickupsCollide(ps->X[i], ps->Y[i], PLAYER_RADIUS))
 		{
 			PlayerScore(p, false);
 		}
 
 		// Players that hit the top of the screen die
-		if (cpBodyGetPosition(p->Body).y + PLAYER_RADIUS >=
-			camera.Y + FIELD_HEIGHT / 2)
+		if (ps->Y[i] + PLAYER_RADIUS >= Game->Camera.Y + FIELD_HEIGHT / 2)
 		{
 			PlayerKill(p);
 		}
@@ -129,120 +197,100 @@ void GameDoLogic(bool* Continue, bool* Error, Uint32 Milliseconds)
 	if (!hasPlayers)
 	{
 		ToTitleScreen(false);
+		// The title screen has set the players up again, below a camera
+		// that is still where the game ended
+		return;
 	}
-	SpaceUpdate(&space, PlayerMinY(), camera.Y, PlayerMaxY(), &players[0]);
+	ProfilerBegin(PROFILER_SPACE);
+	const PlayerSummary *sum = PlayersGetSummary();
+	SpaceUpdate(
+		&Game->Space, sum->EnabledMinY, Game->Camera.Y, sum->MaxY,
+		&Game->Players[0]);
+	ProfilerEnd(PROFILER_SPACE);
 
+	ProfilerBegin(PROFILER_PARTICLES);
 	ParticlesUpdate(Milliseconds);
+	ProfilerEnd(PROFILER_PARTICLES);
 
 	// Players that hit the top of the screen die
-	if (PlayerMaxY() + PLAYER_RADIUS >= camera.Y + FIELD_HEIGHT / 2)
+	if (PlayersGetSummary()->MaxY + PLAYER_RADIUS >=
+		Game->Camera.Y + FIELD_HEIGHT / 2)
 	{
 		ToTitleScreen(false);
 	}
 }
-static float PlayerMiddleY(void)
-{
-	float sum = 0;
-	for (int i = 0; i < MAX_PLAYERS; i++)
-	{
-		const Player *p = &players[i];
-		if (!p->Alive) continue;
-		sum += (float)cpBodyGetPosition(p->Body).y;
-	}
-	return sum / PlayerAliveCount();
-}
-static float PlayerMinY(void)
+void GameOutputFrame(void)
 {
-	float y = NAN;
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	const Camera *c = &Game->Camera;
+	RenderSnapshot *r = RenderBegin();
+	r->Y = MAX(
+		-SCREEN_HEIGHT, SCREEN_Y(DrawLerp(c->PrevY, c->Y)) - SCREEN_HEIGHT / 2);
+	r->NumBlocks = SpaceSprites(&Game->Space, r->Blocks);
+	r->NumPickups = PickupsSprites(r->Pickups, RENDER_MAX_PICKUPS, r->Y);
+	r->NumParticles = ParticlesSprites(r->Particles, r->Y);
+	r->NumPlayers = 0;
+	for (int i = 0; i < Game->PlayerState.Count; i++)
 	{
-		const Player *p = &players[i];
-		if (!p->Enabled) continue;
-		const float py = (float)cpBodyGetPosition(p->Body).y;
-		if (isnan(y) || py < y)
+		if (PlayerSprite(&Game->Players[i], &r->Players[r->NumPlayers]))
 		{
-			y = py;
+			r->NumPlayers++;
 		}
 	}
-	return y;
-}
-static float PlayerMaxY(void)
-{
-	float y = NAN;
-	for (int i = 0; i < MAX_PLAYERS; i++)
+
+	// With many players, only the first few scores fit
+	const int numScores =
+		MIN(PlayersGetSummary()->NumEnabled, HUD_MAX_SCORES);
+	r->NumScores = 0;
+	for (int i = 0; i < Game->PlayerState.Count && r->NumScores < numScores; i++)
 	{
-		const Player *p = &players[i];
-		if (!p->Alive) continue;
-		const float py = (float)cpBodyGetPosition(p->Body).y;
-		if (isnan(y) || py > y)
-		{
-			y = py;
-		}
+		if (!Game->PlayerState.Enabled[i]) continue;
+		r->ScoreSprites[r->NumScores] = Game->Players[i].Sprites;
+		r->Scores[r->NumScores] = Game->Players[i].Score;
+		r->NumScores++;
 	}
-	return y;
+	ProfilerFrameTake(r->ProfileUs);
+	RenderSubmit();
 }
 
-void GameOutputFrame(void)
+void ToGame(void)
 {
-	const float screenYOff =
-		(float)MAX(-SCREEN_HEIGHT, SCREEN_Y(camera.Y) - SCREEN_HEIGHT / 2);
-	// Draw the background.
-	DrawBackground(&BG, screenYOff);
+	Game->Pause = false;
+	Game->GameMs = 0;
+	memset(&Game->Input, 0, sizeof Game->Input);
 
-	SpaceDraw(&space, screenYOff);
-	PickupsDraw(Screen, screenYOff);
-	ParticlesDraw(Screen, screenYOff);
-
-	int c = 0;
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	// Seed the RNG so that the game can be recorded and replayed
+	uint32_t seed = Game->Seed != 0 ? Game->Seed : (uint32_t)time(NULL);
+	if (replay.Mode == REPLAY_MODE_PLAY)
 	{
-		PlayerDraw(&players[i], screenYOff);
-
-		if (!players[i].Enabled) continue;
-
-		// Draw each player's current score.
-		char buf[17];
-		sprintf(buf, "%d", players[i].Score);
-		const SDL_Color white = { 255, 255, 255, 255 };
-		SDL_Surface *t = TTF_RenderText_Blended(font, buf, white);
-		const int x = (c + 1) * SCREEN_WIDTH / (PlayerEnabledCount() + 1);
-		const int wHalf = (t->w + PLAYER_SPRITESHEET_WIDTH) / 2;
-		// Draw the player icon, followed by the score number
-		SDL_Rect src = {
-			0, 0, PLAYER_SPRITESHEET_WIDTH, PLAYER_SPRITESHEET_HEIGHT
-		};
-		SDL_Rect dest = { (Sint16)(x - wHalf), 0, 0, 0 };
-		SDL_BlitSurface(PlayerSpritesheets[i], &src, Screen, &dest);
-		// Draw score number
-		dest.x = (Sint16)(x - wHalf + PLAYER_SPRITESHEET_WIDTH);
-		dest.y = (Sint16)(PLAYER_SPRITESHEET_HEIGHT - t->h) / 2;
-		SDL_BlitSurface(t, NULL, Screen, &dest);
-		SDL_FreeSurface(t);
-
-		c++;
+		seed = replay.Seed;
 	}
+	RngSeedAll(seed);
 
-	SDL_Flip(Screen);
-}
-
-void ToGame(void)
-{
-	Pause = false;
-
-	SpaceReset(&space);
+	SpaceReset(&Game->Space);
 
 	// Reset player positions and velocity
-	for (int i = 0, c = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0, c = 0; i < Game->PlayerState.Count; i++)
 	{
-		PlayerReset(&players[i], c);
-		if (!players[i].Enabled) continue;
+		PlayerReset(&Game->Players[i], c);
+		if (!Game->PlayerState.Enabled[i]) continue;
 		c++;
 	}
-	CameraInit(&camera);
+	CameraInit(&Game->Camera);
 	SoundPlay(SoundStart, 1.0);
 	MusicSetLoud(true);
 
-	GatherInput = GameGatherInput;
-	DoLogic     = GameDoLogic;
-	OutputFrame = GameOutputFrame;
+	if (replay.Mode == REPLAY_MODE_RECORD)
+	{
+		ReplayRecordStart(
+			&replay, seed, Game->PlayerState.Count, Game->PlayerState.Enabled);
+	}
+
+	if (replay.Mode == REPLAY_MODE_PLAY)
+		Game->GatherInput = GameReplayGatherInput;
+	else if (Game->Headless)
+		Game->GatherInput = BotGatherInput;
+	else
+		Game->GatherInput = GameGatherInput;
+	Game->DoLogic     = GameDoLogic;
+	Game->OutputFrame = GameOutputFrame;
 }
@@ -24,7 +24,9 @@
 #include <SDL_mixer.h>
 #include <SDL_ttf.h>
 
+#include "fixed.h"
 #include "init.h"
+#include "text.h"
 
 // All speed and acceleration modifiers follow the same directions.
 // Vertically: Positive values go upward, and negative values go downward.
@@ -99,8 +101,45 @@
 #define FIELD_HEIGHT     (SCREEN_HEIGHT * (FIELD_WIDTH / SCREEN_WIDTH))
 
 // Convert game coordinates to screen coordinates
+#ifdef FIXED_POINT_DRAW
+// Pixels from field units in fixed point, and back; the scales have more
+// fractional bits so that they stay exact far down the field
+enum
+{
+	FIXED_SCREEN_SCALE = (int)(SCREEN_WIDTH / FIELD_WIDTH * 16777216.0),
+	FIXED_FIELD_SCALE = (int)(FIELD_WIDTH / SCREEN_WIDTH * 4294967296.0)
+};
+static inline int FixedToScreen(const Fixed x)
+{
+	return (int)(
+		((int64_t)x * FIXED_SCREEN_SCALE + ((int64_t)1 << 39)) >> 40);
+}
+static inline Fixed FixedFromScreen(const int px)
+{
+	return (Fixed)(((int64_t)px * FIXED_FIELD_SCALE) >> (32 - FIXED_SHIFT));
+}
+#define SCREEN_X_FIXED(_x) FixedToScreen(_x)
+#define SCREEN_Y_FIXED(_y) (SCREEN_HEIGHT - FixedToScreen(_y))
+#define SCREEN_X(_x) SCREEN_X_FIXED(FixedFromFloat(_x))
+#define SCREEN_Y(_y) SCREEN_Y_FIXED(FixedFromFloat(_y))
+#else
 #define SCREEN_X(_x) ((int)roundf((_x) * SCREEN_WIDTH / FIELD_WIDTH))
 #define SCREEN_Y(_y) ((int)roundf(SCREEN_HEIGHT - (_y) * SCREEN_HEIGHT / FIELD_HEIGHT))
+#endif
+
+// How far the frame being drawn is past the last logic step, from 0 to
+// FIXED_ONE of a step; things that move are drawn that far between where
+// they were before and after the step
+extern Fixed DrawAlpha;
+static inline float DrawLerp(const float prev, const float cur)
+{
+#ifdef FIXED_POINT_DRAW
+	const Fixed p = FixedFromFloat(prev);
+	return FixedToFloat(p + FixedMul(FixedFromFloat(cur) - p, DrawAlpha));
+#else
+	return prev + (cur - prev) * (DrawAlpha * (1.0f / FIXED_ONE));
+#endif
+}
 
 extern Mix_Chunk* SoundBeep;
 extern Mix_Chunk* SoundStart;
@@ -108,5 +147,7 @@ extern Mix_Chunk* SoundLose;
 extern Mix_Chunk* SoundScore;
 
 extern TTF_Font *font;
+extern TextAtlas fontAtlas;
 
 extern void ToGame(void);
+extern void GameReplayGatherInput(bool* Continue);
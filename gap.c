@@ -27,12 +27,13 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <math.h>
 
-#include "SDL_image.h"
-
 #include "box.h"
+#include "context.h"
 #include "game.h"
+#include "image.h"
 #include "main.h"
 #include "pickup.h"
+#include "rng.h"
 
 
 #define GAP_SPRITE_WIDTH 318
@@ -47,7 +48,7 @@ void GapInit(struct Gap* gap, const float w, const float y)
 	float gapXs[MAX_GAPS];
 	for (int i = 0; i < MAX_GAPS; i++)
 	{
-		gapXs[i] = w / 2 + (float)rand() / (float)RAND_MAX * (FIELD_WIDTH - w);
+		gapXs[i] = w / 2 + RngFloat(&Game->Rngs[RNG_GAPS]) * (FIELD_WIDTH - w);
 	}
 	qsort(gapXs, MAX_GAPS, sizeof gapXs[0], compareFloat);
 	// Merge gaps if they are too close
@@ -60,29 +61,27 @@ void GapInit(struct Gap* gap, const float w, const float y)
 		}
 	}
 	// Generate blocks
-	CArrayInit(&gap->blocks, sizeof(Block));
-	Block b;
+	gap->numBlocks = 0;
 	float left = 0;
 	for (int i = 0; i < MAX_GAPS; i++)
 	{
 		if (gapXs[i] == 0) continue;
-		BlockInit(&b, left, y, gapXs[i] - w / 2 - left);
-		CArrayPushBack(&gap->blocks, &b);
+		BlockInit(
+			&gap->blocks[gap->numBlocks++], left, y, gapXs[i] - w / 2 - left);
 		left = gapXs[i] + w / 2;
 	}
 	// Add last block
-	BlockInit(&b, left, y, FIELD_WIDTH - left);
-	CArrayPushBack(&gap->blocks, &b);
+	BlockInit(&gap->blocks[gap->numBlocks++], left, y, FIELD_WIDTH - left);
+	BlocksAdd(gap->blocks, gap->numBlocks);
 
 	// Randomly add a pickup above a block
-	if (rand() > (RAND_MAX / 2))
+	if (RngInt(&Game->Rngs[RNG_GAPS], 2) == 0)
 	{
-		const Block *bl = CArrayGet(&gap->blocks, rand() % gap->blocks.size);
-		const cpVect pos = cpBodyGetPosition(bl->Body);
-		PickupsAdd((float)pos.x, (float)pos.y + bl->H / 2);
+		const Block *bl =
+			&gap->blocks[RngInt(&Game->Rngs[RNG_GAPS], gap->numBlocks)];
+		PickupsAdd(bl->X, bl->Y + bl->H / 2);
 	}
 
-	memset(gap->Passed, 0, sizeof gap->Passed);
 	gap->Y = y;
 }
 static int compareFloat(const void *a, const void *b)
@@ -93,19 +92,17 @@ static int compareFloat(const void *a, const void *b)
 }
 void GapRemove(struct Gap* gap)
 {
-	for (int i = 0; i < (int)gap->blocks.size; i++)
-	{
-		BlockRemove(CArrayGet(&gap->blocks, i));
-	}
-	CArrayTerminate(&gap->blocks);
+	BlocksRemove(gap->blocks, gap->numBlocks);
+	gap->numBlocks = 0;
 }
 
-void GapDraw(const struct Gap* gap, const float y)
+int GapSprites(const struct Gap* gap, DrawSprite *sprites)
 {
-	for (int i = 0; i < (int)gap->blocks.size; i++)
+	for (int i = 0; i < gap->numBlocks; i++)
 	{
-		BlockDraw(CArrayGet(&gap->blocks, i), y);
+		BlockSprite(&gap->blocks[i], &sprites[i]);
 	}
+	return gap->numBlocks;
 }
 
 float GapBottom(const struct Gap* gap)
@@ -119,7 +116,7 @@ bool GapSurfacesLoad(void)
 	{
 		char buf[256];
 		sprintf(buf, "data/graphics/floor%d.png", i);
-		GapSurfaces[i] = IMG_Load(buf);
+		GapSurfaces[i] = ImageLoad(buf);
 		if (GapSurfaces[i] == NULL)
 		{
 			return false;
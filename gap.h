@@ -30,27 +30,31 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <chipmunk/chipmunk.h>
 #include <SDL.h>
 
-#include "c_array.h"
+#include "box.h"
+#include "game.h"
 #include "player.h"
 
 // Gaps are a pair of rectangles with a gap in between.
 // The player scores after falling through a gap.
 
+// Gaps merge when they are too close, so there are at most MAX_GAPS + 1
+// blocks between them
+#define GAP_MAX_BLOCKS (MAX_GAPS + 1)
+
 struct Gap
 {
-	CArray blocks;	// of Block
+	Block blocks[GAP_MAX_BLOCKS];
+	int numBlocks;
 	// Where the gap layer is.
 	float Y;
-
-	// Whether each player has passed this gap
-	bool Passed[MAX_PLAYERS];
 };
 
 extern SDL_Surface *GapSurfaces[6];
 
 void GapInit(struct Gap* gap, const float w, const float y);
 void GapRemove(struct Gap* gap);
-void GapDraw(const struct Gap* gap, const float y);
+// Fill in the sprites of the gap's blocks, and return how many
+int GapSprites(const struct Gap* gap, DrawSprite *sprites);
 
 extern float GapBottom(const struct Gap* gap);
 
@@ -30,7 +30,6 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "cfgpath.h"
 #include "init.h"
 #include "main.h"
-#include "text.h"
 #include "utils.h"
 
 
@@ -39,6 +38,11 @@ POSSIBILITY OF SUCH DAMAGE.
 
 CArray HighScores;
 
+// The rendered table, rebuilt when the high scores change
+static SDL_Surface *table = NULL;
+static bool tableDirty = true;
+static void TableFree(void);
+
 void HighScoresInit(void)
 {
 	CArrayInit(&HighScores, sizeof(HighScore));
@@ -74,6 +78,7 @@ void HighScoresInit(void)
 void HighScoresFree(void)
 {
 	CArrayTerminate(&HighScores);
+	TableFree();
 }
 
 void HighScoresAdd(const int s)
@@ -98,6 +103,7 @@ void HighScoresAdd(const int s)
 	{
 		CArrayPushBack(&HighScores, &hsNew);
 	}
+	tableDirty = true;
 
 	// Save to file
 	char buf[MAX_PATH];
@@ -158,31 +164,138 @@ void HighScoreDisplayUpdate(HighScoreDisplay *h, const Uint32 ms)
 	if (h->textCounter > 1.0f) h->textCounter -= 1.0f;
 }
 
-void HighScoreDisplayDraw(HighScoreDisplay *h)
+// Offsets of the table's non-transparent pixels, to recolour the text
+// without touching the rest of the surface
+static Uint32 *tableInk = NULL;
+static int tableInkCount = 0;
+static SDL_Color tableColor;
+
+static void TableFree(void)
 {
-	char buf[2048];
-	strcpy(buf, "High Scores\n\n");
-	const bool countHeight = h->h == 0;
-	if (countHeight) h->h += TTF_FontHeight(hsFont) * 2;
+	SDL_FreeSurface(table);
+	table = NULL;
+	CFREE(tableInk);
+	tableInk = NULL;
+	tableInkCount = 0;
+}
+
+static int TableRenderLine(const char *text, const int y);
+static void TableBuild(void)
+{
+	TableFree();
+	tableDirty = false;
+	const int lineH = TTF_FontHeight(hsFont);
+	const int h = lineH * (2 + (int)HighScores.size);
+	// Take the pixel format from the font renderer, so lines can be copied
+	const SDL_Color white = { 255, 255, 255, 255 };
+	SDL_Surface *t = TTF_RenderText_Blended(hsFont, "#", white);
+	if (t == NULL)
+	{
+		printf("Error: cannot render high scores: %s\n", SDL_GetError());
+		return;
+	}
+	table = SDL_CreateRGBSurface(
+		SDL_SWSURFACE | SDL_SRCALPHA, SCREEN_WIDTH, h, 32,
+		t->format->Rmask, t->format->Gmask, t->format->Bmask,
+		t->format->Amask);
+	SDL_FreeSurface(t);
+	if (table == NULL)
+	{
+		printf("Error: cannot create high score surface: %s\n", SDL_GetError());
+		return;
+	}
+	tableColor = white;
+
+	int y = TableRenderLine("High Scores", 0);
+	y += lineH;
 	for (int i = 0; i < (int)HighScores.size; i++)
 	{
 		const HighScore *hs = CArrayGet(&HighScores, i);
 		char lbuf[256];
 		struct tm *ptm = gmtime(&hs->Time);
-		char tbuf[256];
+		char tbuf[32];
 		strftime(tbuf, sizeof tbuf, "%Y-%m-%d", ptm);
-		sprintf(lbuf, "#%d        %d (%s)\n", i + 1, hs->Score, tbuf);
-		strcat(buf, lbuf);
-		if (countHeight)
+		snprintf(lbuf, sizeof lbuf, "#%d        %d (%s)", i + 1, hs->Score, tbuf);
+		y = TableRenderLine(lbuf, y);
+	}
+
+	// Find the text pixels
+	SDL_LockSurface(table);
+	const Uint32 amask = table->format->Amask;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		tableInkCount = 0;
+		for (int py = 0; py < table->h; py++)
+		{
+			const Uint32 *row =
+				(const Uint32 *)((const Uint8 *)table->pixels + py * table->pitch);
+			for (int px = 0; px < table->w; px++)
+			{
+				if ((row[px] & amask) == 0) continue;
+				if (pass == 1)
+				{
+					tableInk[tableInkCount] =
+						(Uint32)(py * table->pitch / 4 + px);
+				}
+				tableInkCount++;
+			}
+		}
+		if (pass == 0)
 		{
-			h->h += TTF_FontHeight(hsFont);
+			CMALLOC(tableInk, sizeof *tableInk * MAX(tableInkCount, 1));
 		}
 	}
+	SDL_UnlockSurface(table);
+}
+// Render a line centred in the table, returning the y of the next line
+static int TableRenderLine(const char *text, const int y)
+{
+	const SDL_Color white = { 255, 255, 255, 255 };
+	SDL_Surface *t = TTF_RenderText_Blended(hsFont, text, white);
+	if (t != NULL)
+	{
+		// Copy the alpha channel rather than blending it
+		SDL_SetAlpha(t, 0, SDL_ALPHA_OPAQUE);
+		SDL_Rect dest = { (Sint16)((SCREEN_WIDTH - t->w) / 2), (Sint16)y, 0, 0 };
+		SDL_BlitSurface(t, NULL, table, &dest);
+		SDL_FreeSurface(t);
+	}
+	return y + TTF_FontHeight(hsFont);
+}
+static void TableSetColor(const SDL_Color c)
+{
+	if (tableColor.r == c.r && tableColor.g == c.g && tableColor.b == c.b)
+	{
+		return;
+	}
+	tableColor = c;
+	const Uint32 amask = table->format->Amask;
+	const Uint32 rgb = SDL_MapRGB(table->format, c.r, c.g, c.b) & ~amask;
+	SDL_LockSurface(table);
+	Uint32 *pixels = table->pixels;
+	for (int i = 0; i < tableInkCount; i++)
+	{
+		Uint32 *p = &pixels[tableInk[i]];
+		*p = (*p & amask) | rgb;
+	}
+	SDL_UnlockSurface(table);
+}
+
+void HighScoreDisplayDraw(HighScoreDisplay *h)
+{
+	if (tableDirty)
+	{
+		TableBuild();
+	}
+	if (table == NULL) return;
+	h->h = table->h;
 	// Pulsate
 	const float scalar =
 		h->textCounter > 0.5f ? 1.0f - h->textCounter : h->textCounter;
 	SDL_Color c;
 	c.b = TEXT_BLUE_LOW + (Uint8)((TEXT_BLUE_HIGH - TEXT_BLUE_LOW) * scalar);
 	c.r = c.g = c.b / 2;
-	TextRenderCentered(Screen, hsFont, buf, (int)h->y, c);
-}
\ No newline at end of file
+	TableSetColor(c);
+	SDL_Rect dest = { 0, (Sint16)h->y, 0, 0 };
+	SDL_BlitSurface(table, NULL, Screen, &dest);
+}
@@ -0,0 +1,103 @@
+#include "image.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <SDL_image.h>
+
+// Colour used for transparent pixels in colour-keyed images
+#define KEY_R 255
+#define KEY_G 0
+#define KEY_B 255
+
+static SDL_Surface *ToColorKey(SDL_Surface *s);
+SDL_Surface *ImageLoad(const char *path)
+{
+	SDL_Surface *s = IMG_Load(path);
+	if (s == NULL || SDL_GetVideoSurface() == NULL) return s;
+	SDL_Surface *c;
+	if (s->format->Amask == 0)
+	{
+		// Any colour key is carried over by the conversion
+		c = SDL_DisplayFormat(s);
+		if (c != NULL && (c->flags & SDL_SRCCOLORKEY))
+		{
+			SDL_SetColorKey(
+				c, SDL_SRCCOLORKEY | SDL_RLEACCEL, c->format->colorkey);
+		}
+	}
+	else
+	{
+		c = ToColorKey(s);
+		if (c == NULL)
+		{
+			c = SDL_DisplayFormatAlpha(s);
+			if (c != NULL)
+			{
+				SDL_SetAlpha(c, SDL_SRCALPHA | SDL_RLEACCEL, SDL_ALPHA_OPAQUE);
+			}
+		}
+	}
+	if (c == NULL)
+	{
+		printf("Error: cannot convert %s: %s\n", path, SDL_GetError());
+		return s;
+	}
+	SDL_FreeSurface(s);
+	return c;
+}
+
+// Convert an image with only fully transparent or fully opaque pixels to
+// a colour-keyed one, or return NULL if it has partial transparency
+static bool IsAlphaBinary(SDL_Surface *s, const Uint32 key);
+static SDL_Surface *ToColorKey(SDL_Surface *s)
+{
+	if (s->format->BytesPerPixel != 4) return NULL;
+	const Uint32 key = SDL_MapRGB(s->format, KEY_R, KEY_G, KEY_B);
+	if (!IsAlphaBinary(s, key)) return NULL;
+	// Paint the transparent pixels with the key and drop the alpha channel
+	const Uint32 amask = s->format->Amask;
+	SDL_LockSurface(s);
+	for (int y = 0; y < s->h; y++)
+	{
+		Uint32 *row = (Uint32 *)((Uint8 *)s->pixels + y * s->pitch);
+		for (int x = 0; x < s->w; x++)
+		{
+			if ((row[x] & amask) == 0) row[x] = key;
+		}
+	}
+	SDL_UnlockSurface(s);
+	SDL_SetAlpha(s, 0, SDL_ALPHA_OPAQUE);
+	SDL_SetColorKey(s, SDL_SRCCOLORKEY, key);
+	SDL_Surface *c = SDL_DisplayFormat(s);
+	if (c != NULL)
+	{
+		SDL_SetColorKey(
+			c, SDL_SRCCOLORKEY | SDL_RLEACCEL, c->format->colorkey);
+	}
+	return c;
+}
+// Also checks that no opaque pixel is the colour of the key
+static bool IsAlphaBinary(SDL_Surface *s, const Uint32 key)
+{
+	const Uint32 amask = s->format->Amask;
+	bool binary = true;
+	SDL_LockSurface(s);
+	for (int y = 0; y < s->h && binary; y++)
+	{
+		const Uint32 *row =
+			(const Uint32 *)((const Uint8 *)s->pixels + y * s->pitch);
+		for (int x = 0; x < s->w; x++)
+		{
+			const Uint32 a = row[x] & amask;
+			if ((a != 0 && a != amask) ||
+				(a == amask && (row[x] & ~amask) == (key & ~amask)))
+			{
+				binary = false;
+				break;
+			}
+		}
+	}
+	SDL_UnlockSurface(s);
+	return binary;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <SDL.h>
+
+// Load an image and convert it to the display format, so that blits need
+// no per-pixel format conversion. Images whose alpha is all-or-nothing
+// become RLE colour-keyed surfaces; others keep per-pixel alpha.
+// Before the video mode is set, the image is returned as loaded.
+SDL_Surface *ImageLoad(const char *path);
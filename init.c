@@ -20,29 +20,47 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <time.h>
 
 #include "SDL.h"
-#include "SDL_image.h"
 
+#include "context.h"
 #include "gap.h"
 #include "game.h"
 #include "main.h"
 #include "high_score.h"
+#include "image.h"
 #include "init.h"
 #include "input.h"
 #include "particle.h"
 #include "pickup.h"
 #include "platform.h"
 #include "player.h"
+#include "profiler.h"
+#include "replay.h"
+#include "rng.h"
 #include "space.h"
 #include "sound.h"
 #include "title.h"
+#include "trace.h"
 
 SDL_Surface *icon = NULL;
 
+// Display and options; defined here rather than in main.c so that the game
+// logic can be linked without main.c, as with sim.h
+SDL_Surface *Screen = NULL;
+bool Headless = false;
+int PhysicsThreads = 0;
+SpaceIndex PhysicsIndex = SPACE_INDEX_BBTREE;
+Fixed DrawAlpha = FIXED_ONE;
+
 void Initialize(bool* Continue, bool* Error)
 {
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
+	RngSeedAll(Game->Seed != 0 ? Game->Seed : (uint32_t)time(NULL));
+	Game->Headless = Headless;
+
+	// Headless runs only need the game logic; skip video and audio
+	if (SDL_Init(Headless ? 0 : SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
 	{
 		*Continue = false;  *Error = true;
 		printf("SDL initialisation failed: %s\n", SDL_GetError());
@@ -52,27 +70,30 @@ void Initialize(bool* Continue, bool* Error)
 	else
 		printf("SDL initialisation succeeded\n");
 
-	Screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_HWSURFACE | SDL_DOUBLEBUF);
-
-	if (Screen == NULL)
+	if (!Headless)
 	{
-		*Continue = false;  *Error = true;
-		printf("SDL_SetVideoMode failed: %s\n", SDL_GetError());
-		SDL_ClearError();
-		return;
-	}
-	else
-		printf("SDL_SetVideoMode succeeded\n");
+		Screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_HWSURFACE | SDL_DOUBLEBUF);
 
-	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 1024) == -1)
-	{
-		*Continue = false;  *Error = true;
-		printf("Mix_OpenAudio failed: %s\n", SDL_GetError());
-		SDL_ClearError();
-		return;
+		if (Screen == NULL)
+		{
+			*Continue = false;  *Error = true;
+			printf("SDL_SetVideoMode failed: %s\n", SDL_GetError());
+			SDL_ClearError();
+			return;
+		}
+		else
+			printf("SDL_SetVideoMode succeeded\n");
+
+		if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 1024) == -1)
+		{
+			*Continue = false;  *Error = true;
+			printf("Mix_OpenAudio failed: %s\n", SDL_GetError());
+			SDL_ClearError();
+			return;
+		}
+		else
+			printf("Mix_OpenAudio succeeded\n");
 	}
-	else
-		printf("Mix_OpenAudio succeeded\n");
 
 	InputInit();
 	HighScoresInit();
@@ -87,10 +108,8 @@ void Initialize(bool* Continue, bool* Error)
 	else
 		printf("TTF_Init succeeded\n");
 
-	SDL_WM_SetCaption("FallingTime", NULL);
-
 #define LOAD_IMG(_surface, _path)\
-	_surface = IMG_Load("data/graphics/" _path);\
+	_surface = ImageLoad("data/graphics/" _path);\
 	if (_surface == NULL)\
 	{\
 		*Continue = false;  *Error = true;\
@@ -98,8 +117,12 @@ void Initialize(bool* Continue, bool* Error)
 		SDL_ClearError();\
 		return;\
 	}
-	LOAD_IMG(icon, "icon.png");
-	SDL_WM_SetIcon(icon, NULL);
+	if (!Headless)
+	{
+		SDL_WM_SetCaption("FallingTime", NULL);
+		LOAD_IMG(icon, "icon.png");
+		SDL_WM_SetIcon(icon, NULL);
+	}
 
 	LOAD_IMG(PlayerSpritesheets[0], "penguin_ball.png");
 	LOAD_IMG(PlayerSpritesheets[1], "penguin_black.png");
@@ -148,20 +171,23 @@ void Initialize(bool* Continue, bool* Error)
 		SDL_ClearError();\
 		return;\
 	}
-	LOAD_SOUND(SoundBeep, "beep.ogg");
-	LOAD_SOUND(SoundPlayerBounce, "bounce.ogg");
-	LOAD_SOUND(SoundStart, "start.ogg");
-	LOAD_SOUND(SoundLose, "lose.ogg");
-	LOAD_SOUND(SoundScore, "score.ogg");
-	SoundLoad();
-
-	music = Mix_LoadMUS("data/sounds/music.ogg");
-	if (music == NULL)
+	if (!Headless)
 	{
-		*Continue = false;  *Error = true;
-		printf("Mix_LoadMUS failed: %s\n", SDL_GetError());
-		SDL_ClearError();
-		return;
+		LOAD_SOUND(SoundBeep, "beep.ogg");
+		LOAD_SOUND(SoundPlayerBounce, "bounce.ogg");
+		LOAD_SOUND(SoundStart, "start.ogg");
+		LOAD_SOUND(SoundLose, "lose.ogg");
+		LOAD_SOUND(SoundScore, "score.ogg");
+		SoundLoad();
+
+		music = Mix_LoadMUS("data/sounds/music.ogg");
+		if (music == NULL)
+		{
+			*Continue = false;  *Error = true;
+			printf("Mix_LoadMUS failed: %s\n", SDL_GetError());
+			SDL_ClearError();
+			return;
+		}
 	}
 
 #define LOAD_FONT(_f, _file, _size)\
@@ -175,27 +201,34 @@ void Initialize(bool* Continue, bool* Error)
 	}
 	LOAD_FONT(font, "LondrinaSolid-Regular.otf", 20);
 	LOAD_FONT(hsFont, "LondrinaSolid-Regular.otf", 16);
+	LOAD_FONT(profilerFont, "LondrinaSolid-Regular.otf", 9);
+	TextAtlasInit(&fontAtlas, font);
 
-	SpaceInit(&space);
+	SpaceInit(&Game->Space, PhysicsThreads, PhysicsIndex);
 	ParticlesInit();
 	PickupsInit();
 
-	SDL_ShowCursor(0);
+	if (!Headless)
+	{
+		SDL_ShowCursor(0);
+
+		InitializePlatform();
 
-	InitializePlatform();
+		MusicSetLoud(false);
+		Mix_PlayMusic(music, -1);
+	}
 
 	// Title screen. (-> title.c)
-	MusicSetLoud(false);
-	Mix_PlayMusic(music, -1);
 	ToTitleScreen(true);
 }
 
 void Finalize()
 {
+	ReplayEnd(&replay);
 	PickupsFree();
 	ParticlesFree();
-	SpaceFree(&space);
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	SpaceFree(&Game->Space);
+	for (int i = 0; i < PLAYER_SPRITESHEETS; i++)
 	{
 		SDL_FreeSurface(PlayerSpritesheets[i]);
 	}
@@ -214,8 +247,12 @@ void Finalize()
 	Mix_FreeChunk(SoundScore);
 	Mix_FreeMusic(music);
 	SoundFree();
+	TextAtlasTerminate(&fontAtlas);
 	TTF_CloseFont(font);
 	TTF_CloseFont(hsFont);
+	ProfilerFree();
+	TraceFree();
+	TTF_CloseFont(profilerFont);
 	HighScoresFree();
 	InputFree();
 	SDL_Quit();
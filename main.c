@@ -17,42 +17,498 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "SDL.h"
 
+#include "batch.h"
+#include "bot.h"
+#include "context.h"
+#include "game.h"
 #include "main.h"
 #include "init.h"
+#include "particle.h"
 #include "platform.h"
+#include "player.h"
+#include "profiler.h"
+#include "render.h"
+#include "replay.h"
+#include "rng.h"
+#include "sim.h"
+#include "space.h"
+#include "title.h"
+#include "trace.h"
+#include "trajectory.h"
+#include "utils.h"
 #include "SDL_image.h"
 
+#define HEADLESS_DEFAULT_FRAMES 100000
+// Frame limit for each game of a batch: two hours of play, which bot games
+// rarely reach
+#define BATCH_DEFAULT_FRAMES (2 * 60 * 60 * 1000 / HEADLESS_FRAME_MS)
+#define SIM_BENCH_DEFAULT_INSTANCES 16
+#define SIM_BENCH_FRAMES 20000
+
 static bool         Continue                         = true;
 static bool         Error                            = false;
+static int          HeadlessFrames                   = HEADLESS_DEFAULT_FRAMES;
+static bool         BenchBroadphase                  = false;
+static int          BatchGames                       = 0;
+static int          BatchFrames                      = BATCH_DEFAULT_FRAMES;
+static int          BatchThreads                     = 0;
+static int          SimBenchInstances                = 0;
+static double       FrameRate                        = FPS;
+static Uint32       FrameSpinUs                      = 0;
+static bool         ShowFrameStats                   = false;
+static bool         RenderThreaded                   = false;
 
-       SDL_Surface* Screen                           = NULL;
-
-       TGatherInput GatherInput;
-       TDoLogic     DoLogic;
-       TOutputFrame OutputFrame;
-
+static void ParseArgs(int argc, char* argv[]);
+static void RunHeadless(void);
+static void BroadphaseBenchmark(void);
+static void SimBenchmark(void);
+static void PrintFrameStats(void);
 int main(int argc, char* argv[])
 {
-	(void)argc;
-	(void)argv;
+	ParseArgs(argc, argv);
+	if (SimBenchInstances > 0)
+	{
+		SimBenchmark();
+		return 0;
+	}
+	// The recording decides how many players there are
+	if (replay.Mode == REPLAY_MODE_PLAY)
+	{
+		if (!ReplayPlayStart(&replay))
+		{
+			return 1;
+		}
+		Game->PlayerState.Count = replay.Count;
+	}
 	Initialize(&Continue, &Error);
-	Uint32 Duration = 16;
+	if (Continue && replay.Mode == REPLAY_MODE_PLAY)
+	{
+		// Jump straight into the recorded game
+		TitleScreenStartGame(replay.Enabled);
+	}
+	if (BenchBroadphase)
+	{
+		BroadphaseBenchmark();
+		Finalize();
+		return Error ? 1 : 0;
+	}
+	if (BatchGames > 0)
+	{
+		BatchRun(BatchGames, BatchFrames, BatchThreads);
+		Finalize();
+		return Error ? 1 : 0;
+	}
+	if (Headless)
+	{
+		RunHeadless();
+		Finalize();
+		return Error ? 1 : 0;
+	}
+	SetFramePacing(FrameRate, FrameSpinUs);
+	if (RenderThreaded)
+	{
+		RenderStart();
+	}
+	// Real time that the logic has yet to catch up on, in microseconds
+	Uint32 lag = 0;
+	Uint32 elapsed = LOGIC_STEP_MS * 1000;
 	while (Continue)
 	{
-		GatherInput(&Continue);
-		if (!Continue)
-			break;
-		DoLogic(&Continue, &Error, Duration);
+		TraceBegin("frame");
+		lag = MIN(lag + elapsed, LOGIC_MAX_STEPS * LOGIC_STEP_MS * 1000);
+		while (lag >= LOGIC_STEP_MS * 1000)
+		{
+			TraceBegin("input");
+			ProfilerBegin(PROFILER_INPUT);
+			Game->GatherInput(&Continue);
+			ProfilerEnd(PROFILER_INPUT);
+			TraceEnd();
+			if (!Continue)
+				break;
+			TraceBegin("logic");
+			Game->DoLogic(&Continue, &Error, LOGIC_STEP_MS);
+			TraceEnd();
+			if (!Continue)
+				break;
+			lag -= LOGIC_STEP_MS * 1000;
+		}
 		if (!Continue)
+		{
+			TraceEnd();
 			break;
-		OutputFrame();
-		Duration = ToNextFrame();
+		}
+		// Draw what is left over as part of a step
+		DrawAlpha =
+			(Fixed)(((int64_t)lag << FIXED_SHIFT) / (LOGIC_STEP_MS * 1000));
+		TraceBegin("output");
+		Game->OutputFrame();
+		TraceEnd();
+		TraceBegin("wait");
+		elapsed = ToNextFrame();
+		TraceEnd();
+		TraceEnd();
+	}
+	RenderStop();
+	if (ShowFrameStats)
+	{
+		PrintFrameStats();
 	}
 	Finalize();
 	return Error ? 1 : 0;
 }
+
+static void ParseArgs(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		// --headless [frames]
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			Headless = true;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+			{
+				HeadlessFrames = atoi(argv[++i]);
+			}
+		}
+		// --record <file>: record each game, overwriting the last one
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+		{
+			ReplayInit(&replay, REPLAY_MODE_RECORD, argv[++i]);
+		}
+		// --replay <file>: play back a recorded game, then exit
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			ReplayInit(&replay, REPLAY_MODE_PLAY, argv[++i]);
+		}
+		// --save-trajectory <file>: save the player positions of each
+		// headless frame
+		else if (strcmp(argv[i], "--save-trajectory") == 0 && i + 1 < argc)
+		{
+			TrajectoryInit(&trajectory, TRAJECTORY_MODE_SAVE, argv[++i]);
+		}
+		// --check-trajectory <file>: compare the player positions of each
+		// headless frame with a saved trajectory
+		else if (strcmp(argv[i], "--check-trajectory") == 0 && i + 1 < argc)
+		{
+			TrajectoryInit(&trajectory, TRAJECTORY_MODE_CHECK, argv[++i]);
+		}
+		// --threads <n>: solve physics on n threads, 0 for one per core
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			const int threads = atoi(argv[++i]);
+			PhysicsThreads = threads > 0 ? threads : SPACE_THREADS_ALL;
+		}
+		// --bench-particles: time the particle kernels, then exit
+		else if (strcmp(argv[i], "--bench-particles") == 0)
+		{
+			SDL_Init(0);
+			ParticlesBenchmark();
+			SDL_Quit();
+			exit(0);
+		}
+		// --bench-physics: time the physics solvers, then exit
+		else if (strcmp(argv[i], "--bench-physics") == 0)
+		{
+			SDL_Init(0);
+			SpaceBenchmark();
+			SDL_Quit();
+			exit(0);
+		}
+		// --broadphase <bbtree|hash|sweep>: physics broadphase to use
+		else if (strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc)
+		{
+			PhysicsIndex = SpaceIndexParse(argv[++i]);
+			if (PhysicsIndex == SPACE_INDEX_COUNT)
+			{
+				printf("Error: unknown broadphase %s\n", argv[i]);
+				exit(1);
+			}
+		}
+		// --bench-broadphase [frames]: time each broadphase over the same
+		// headless games, then exit
+		else if (strcmp(argv[i], "--bench-broadphase") == 0)
+		{
+			Headless = true;
+			BenchBroadphase = true;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+			{
+				HeadlessFrames = atoi(argv[++i]);
+			}
+		}
+		// --players <n>: number of players; past the human players, the
+		// rest are bots
+		else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc)
+		{
+			const int count = atoi(argv[++i]);
+			if (count < 1 || count > MAX_PLAYERS)
+			{
+				printf(
+					"Error: players must be between 1 and %d\n", MAX_PLAYERS);
+				exit(1);
+			}
+			Game->PlayerState.Count = count;
+		}
+		// --batch <games> [frames]: play games headless on a pool of
+		// threads, print statistics, then exit
+		else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+		{
+			Headless = true;
+			BatchGames = atoi(argv[++i]);
+			if (BatchGames < 1)
+			{
+				printf("Error: batch must have at least one game\n");
+				exit(1);
+			}
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+			{
+				BatchFrames = atoi(argv[++i]);
+			}
+		}
+		// --bot-skill <skill>: scale the bots' steering, 1 for full strength
+		else if (strcmp(argv[i], "--bot-skill") == 0 && i + 1 < argc)
+		{
+			BotSkill = (float)atof(argv[++i]);
+		}
+		// --batch-threads <n>: threads for --batch, 0 for one per core
+		else if (strcmp(argv[i], "--batch-threads") == 0 && i + 1 < argc)
+		{
+			BatchThreads = atoi(argv[++i]);
+		}
+		// --bench-sim [instances]: time the environment API, then exit
+		else if (strcmp(argv[i], "--bench-sim") == 0)
+		{
+			SimBenchInstances = SIM_BENCH_DEFAULT_INSTANCES;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+			{
+				SimBenchInstances = atoi(argv[++i]);
+			}
+		}
+		// --fps <n>: frames to display per second, 60 by default
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+		{
+			FrameRate = atof(argv[++i]);
+			if (FrameRate <= 0)
+			{
+				printf("Error: fps must be more than 0\n");
+				exit(1);
+			}
+		}
+		// --frame-spin <us>: spin rather than sleep for the last us
+		// microseconds of each frame
+		else if (strcmp(argv[i], "--frame-spin") == 0 && i + 1 < argc)
+		{
+			FrameSpinUs = (Uint32)atoi(argv[++i]);
+		}
+		// --frame-stats: print frame timing statistics on exit
+		else if (strcmp(argv[i], "--frame-stats") == 0)
+		{
+			ShowFrameStats = true;
+		}
+		// --render-thread: draw games on a thread of their own
+		else if (strcmp(argv[i], "--render-thread") == 0)
+		{
+			RenderThreaded = true;
+		}
+		// --seed <n>: start every game from the same seed
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			Game->Seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+		}
+		// --trace <file>: write a Chrome trace of the last frames on exit
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			TraceInit(argv[++i]);
+		}
+	}
+}
+
+// Run the game logic as fast as possible, without video, audio or frame
+// pacing. Unless replaying, players are driven by the bot and games restart
+// by themselves from the title screen.
+static void RunHeadless(void)
+{
+	if (!TrajectoryStart(&trajectory, Game->PlayerState.Count))
+	{
+		Error = true;
+		return;
+	}
+	const Uint32 start = SDL_GetTicks();
+	int frames;
+	for (frames = 0; Continue && frames < HeadlessFrames; frames++)
+	{
+		TraceBegin("frame");
+		TraceBegin("input");
+		Game->GatherInput(&Continue);
+		TraceEnd();
+		if (Continue)
+		{
+			TraceBegin("logic");
+			Game->DoLogic(&Continue, &Error, HEADLESS_FRAME_MS);
+			TraceEnd();
+			TrajectoryFrame(&trajectory);
+		}
+		TraceEnd();
+	}
+	const Uint32 elapsed = MAX(SDL_GetTicks() - start, 1);
+	printf(
+		"Simulated %d frames in %u ms (%.1f fps)\n",
+		frames, (unsigned)elapsed, frames * 1000.0 / elapsed);
+	TrajectoryEnd(&trajectory);
+}
+
+static void PrintFrameStats(void)
+{
+	const FrameStats *s = GetFrameStats();
+	printf(
+		"%u frames, target %.3f ms: mean %.3f ms, sd %.3f ms, "
+		"min %.3f ms, max %.3f ms\n",
+		(unsigned)s->Frames, 1000.0 / FrameRate, s->MeanUs / 1000,
+		s->SdUs / 1000, s->MinUs / 1000, s->MaxUs / 1000);
+	printf(
+		"%u late frames; ended %.1f us after the target on average, "
+		"%.1f us at most\n",
+		(unsigned)s->Late, s->MeanOvershootUs, s->MaxOvershootUs);
+}
+
+static uint64_t collideStartUs;
+static uint64_t collideUs;
+// The hook TimeCollide replaces, such as --trace's, which it still calls
+static cpTraceFunc collideNextHook;
+static void TimeCollide(const char *name, cpBool begin);
+// Play the same bot-driven games once with each broadphase, timing the
+// collision detection phase of the physics steps
+static void BroadphaseBenchmark(void)
+{
+	if (Game->Seed == 0)
+	{
+		Game->Seed = 1;
+	}
+	collideNextHook = cpTraceHook;
+	cpTraceHook = TimeCollide;
+	printf(
+		"Broadphase, %d headless frames each, seed %u\n",
+		HeadlessFrames, (unsigned)Game->Seed);
+	for (int i = 0; Continue && i < SPACE_INDEX_COUNT; i++)
+	{
+		// Start over from the title screen, with a new physics space
+		Game->Space.Index = (SpaceIndex)i;
+		RngSeedAll(Game->Seed);
+		ToTitleScreen(true);
+		collideUs = 0;
+		printf("%s: ", SpaceIndexName(Game->Space.Index));
+		RunHeadless();
+		printf(
+			"  collision detection %.2f us per frame\n",
+			(double)collideUs / HeadlessFrames);
+	}
+	cpTraceHook = collideNextHook;
+}
+static void TimeCollide(const char *name, cpBool begin)
+{
+	if (collideNextHook != NULL)
+	{
+		collideNextHook(name, begin);
+	}
+	if (strcmp(name, "collide") != 0) return;
+	if (begin)
+	{
+		collideStartUs = TraceNowUs();
+	}
+	else
+	{
+		collideUs += TraceNowUs() - collideStartUs;
+	}
+}
+
+static float SimBenchAction(const float *obs, const int player);
+// Step instances of the environment API as a bot trainer would, driving
+// the players from the observations alone; like the API itself, this runs
+// without initialising SDL or loading any data
+static void SimBenchmark(void)
+{
+	const int n = SimBenchInstances;
+	const int players = Game->PlayerState.Count;
+	Sim *s = SimNew(n, players, true);
+	if (s == NULL) return;
+	const int obsSize = SimObsSize(s);
+	float *obs = malloc(n * obsSize * sizeof *obs);
+	float *actions = malloc(n * players * sizeof *actions);
+	float *rewards = malloc(n * players * sizeof *rewards);
+	uint8_t *dones = malloc(n);
+	if (obs == NULL || actions == NULL || rewards == NULL || dones == NULL)
+	{
+		printf("Error: cannot allocate %d instances\n", n);
+		goto bail;
+	}
+
+	SimReset(s, Game->Seed != 0 ? Game->Seed : 1, obs);
+	double rewardSum = 0;
+	int games = 0;
+	const uint64_t start = TraceNowUs();
+	for (int f = 0; f < SIM_BENCH_FRAMES; f++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			for (int j = 0; j < players; j++)
+			{
+				actions[i * players + j] =
+					SimBenchAction(obs + i * obsSize, j);
+			}
+		}
+		SimStep(s, actions, obs, rewards, dones);
+		for (int i = 0; i < n * players; i++)
+		{
+			rewardSum += rewards[i];
+		}
+		for (int i = 0; i < n; i++)
+		{
+			games += dones[i];
+		}
+	}
+	const double elapsed = MAX(TraceNowUs() - start, 1) * 0.000001;
+	const double steps = (double)SIM_BENCH_FRAMES * n;
+	printf(
+		"%d instances of %d players, %d frames: %.0f steps/s "
+		"(%.1f million per hour)\n",
+		n, players, SIM_BENCH_FRAMES, steps / elapsed,
+		steps / elapsed * 3600 / 1000000);
+	printf(
+		"%d games ended, %.1f points per player per minute of play\n",
+		games, rewardSum / players / (steps * HEADLESS_FRAME_MS / 60000));
+
+bail:
+	free(obs);
+	free(actions);
+	free(rewards);
+	free(dones);
+	SimFree(s);
+}
+// Steer for the middle of the closest opening of the next gap
+static float SimBenchAction(const float *obs, const int player)
+{
+	const float *p = obs + 1 + player * SIM_OBS_PLAYER;
+	const float *g = obs + 1 + Game->PlayerState.Count * SIM_OBS_PLAYER;
+	float target = p[0];
+	float bestDistance = FIELD_WIDTH;
+	for (int i = 0; i < SIM_OBS_OPENINGS; i++)
+	{
+		const float left = g[1 + i * 2];
+		const float right = g[2 + i * 2];
+		if (right <= left) continue;
+		const float mid = (left + right) / 2;
+		if (fabsf(mid - p[0]) < bestDistance)
+		{
+			bestDistance = fabsf(mid - p[0]);
+			target = mid;
+		}
+	}
+	return CLAMP((target - p[0]) * 4.0f - p[2], -1.0f, 1.0f);
+}
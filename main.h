@@ -21,17 +21,32 @@
 #define _MAIN_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "SDL.h"
 
 #include "bg.h"
+#include "space.h"
+
+// The game logic always advances by this fixed step, in milliseconds;
+// displayed frames run as many steps as real time calls for
+#define LOGIC_STEP_MS 8
+// Most steps to run for one displayed frame; past this, the game slows
+// down rather than falling further and further behind
+#define LOGIC_MAX_STEPS 8
+// Fixed time step used when running headless, in milliseconds
+#define HEADLESS_FRAME_MS LOGIC_STEP_MS
 
 typedef void (*TGatherInput) (bool* Continue);
 typedef void (*TDoLogic) (bool* Continue, bool* Error, Uint32 Milliseconds);
 typedef void (*TOutputFrame) (void);
 
 extern SDL_Surface* Screen;
-extern TGatherInput GatherInput;
-extern TDoLogic     DoLogic;
-extern TOutputFrame OutputFrame;
+
+// Running without video, audio or frame pacing
+extern bool Headless;
+// Physics solver threads, as passed to SpaceInit
+extern int PhysicsThreads;
+// Broadphase, as passed to SpaceInit
+extern SpaceIndex PhysicsIndex;
 
 #endif /* !defined(_MAIN_H_) */
@@ -30,43 +30,99 @@ POSSIBILITY OF SUCH DAMAGE.
 #define M_PI 3.14159265358979323846264338327950288
 #endif
 #include <stdbool.h>
+#include <stdlib.h>
 
+#if defined(FIXED_POINT_DRAW)
+// Fixed-point builds are for FPU-less targets, which have no SIMD either
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PARTICLE_SIMD "SSE2"
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PARTICLE_SIMD "NEON"
+#endif
+
+#include "context.h"
 #include "game.h"
+#include "rng.h"
+#include "utils.h"
 
 
-typedef struct
-{
-	Animation anim;	// note: no ownership, don't free
-	float x;
-	float y;
-	float dx;
-	float dy;
-} Particle;
+#ifdef FIXED_POINT_DRAW
+#define COORD(_f) FixedFromFloat(_f)
+#define COORD_MUL(_a, _b) FixedMul((_a), (_b))
+#define COORD_SECONDS(_ms) ((Fixed)((_ms) * FIXED_ONE / 1000))
+#define COORD_FROM_SCREEN(_px) FixedFromScreen(_px)
+#define COORD_SCREEN_X(_x) SCREEN_X_FIXED(_x)
+#define COORD_SCREEN_Y(_y) SCREEN_Y_FIXED(_y)
+#else
+#define COORD(_f) (_f)
+#define COORD_MUL(_a, _b) ((_a) * (_b))
+#define COORD_SECONDS(_ms) ((_ms) / 1000.0f)
+#define COORD_FROM_SCREEN(_px) ((_px) * FIELD_HEIGHT / SCREEN_HEIGHT)
+#define COORD_SCREEN_X(_x) SCREEN_X(_x)
+#define COORD_SCREEN_Y(_y) SCREEN_Y(_y)
+#endif
 
-CArray Particles;
+// Animations shared by the particles; not owned, don't free
+static const Animation *anims[MAX_PARTICLE_ANIMS];
+static int animMsPerFrame[MAX_PARTICLE_ANIMS];
+static int animFrames[MAX_PARTICLE_ANIMS];
+static int animCount = 0;
 
 
 void ParticlesInit(void)
 {
-	CArrayInit(&Particles, sizeof(Particle));
+	Game->Particles.Count = 0;
+	animCount = 0;
 }
 void ParticlesFree(void)
 {
-	CArrayTerminate(&Particles);
+	ParticlesClear();
+}
+void ParticlesClear(void)
+{
+	Game->Particles.Count = 0;
+}
+
+// Find the animation's index, adding it if it is new
+static int AnimId(const Animation *anim)
+{
+	for (int i = 0; i < animCount; i++)
+	{
+		if (anims[i] == anim) return i;
+	}
+	if (animCount == MAX_PARTICLE_ANIMS)
+	{
+		printf("Error: too many particle animations\n");
+		return -1;
+	}
+	anims[animCount] = anim;
+	animMsPerFrame[animCount] = 1000 / anim->frameRate;
+	animFrames[animCount] =
+		(anim->image->w / anim->w) * (anim->image->h / anim->h);
+	return animCount++;
 }
 
 void ParticlesAdd(
 	const Animation *anim, const float x, const float y,
 	const float dx, const float dy)
 {
-	Particle p;
-	memset(&p, 0, sizeof p);
-	memcpy(&p.anim, anim, sizeof *anim);
-	p.x = x;
-	p.y = y;
-	p.dx = dx;
-	p.dy = dy;
-	CArrayPushBack(&Particles, &p);
+	ParticlePool *p = &Game->Particles;
+	// Also keeps other threads' games off the shared animation list
+	if (Game->Offscreen) return;
+	if (p->Count == PARTICLE_CAPACITY) return;
+	const int id = AnimId(anim);
+	if (id < 0) return;
+	const int i = p->Count++;
+	p->X[i] = COORD(x);
+	p->Y[i] = COORD(y);
+	p->DX[i] = COORD(dx);
+	p->DY[i] = COORD(dy);
+	p->FrameCounter[i] = 0;
+	p->Frame[i] = 0;
+	p->FrameMs[i] = animMsPerFrame[id];
+	p->Anim[i] = (Uint8)id;
 }
 void ParticlesAddExplosion(
 	const Animation *anim, const float x, const float y, const int n,
@@ -74,41 +130,326 @@ void ParticlesAddExplosion(
 {
 	for (int i = 0; i < n; i++)
 	{
-		const float theta = (float)rand() / RAND_MAX * (float)M_PI * 2;
+		const float theta = RngFloat(&Game->Rngs[RNG_PARTICLES]) * (float)M_PI * 2;
 		ParticlesAdd(
 			anim, x, y, (float)cos(theta) * speed, (float)sin(theta) * speed);
 	}
 }
 
-static bool ParticleUpdate(Particle *p, const Uint32 ms);
+// Kernels over contiguous particle arrays. Each has a scalar version, used
+// for the elements left over by the SIMD ones and when SIMD is unavailable.
+
+static void IntegrateScalar(
+	ParticleCoord *x, ParticleCoord *y, const ParticleCoord *dx,
+	const ParticleCoord *dy, const int start, const int n,
+	const ParticleCoord dt)
+{
+	for (int i = start; i < n; i++)
+	{
+		x[i] += COORD_MUL(dx[i], dt);
+		y[i] += COORD_MUL(dy[i], dt);
+	}
+}
+static void Integrate(
+	ParticleCoord *x, ParticleCoord *y, const ParticleCoord *dx,
+	const ParticleCoord *dy, const int n, const ParticleCoord dt)
+{
+	int i = 0;
+#if defined(PARTICLE_SIMD) && defined(__SSE2__)
+	const __m128 vdt = _mm_set1_ps(dt);
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(x + i, _mm_add_ps(
+			_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(dx + i), vdt)));
+		_mm_storeu_ps(y + i, _mm_add_ps(
+			_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(dy + i), vdt)));
+	}
+#elif defined(PARTICLE_SIMD)
+	const float32x4_t vdt = vdupq_n_f32(dt);
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1q_f32(x + i, vmlaq_f32(vld1q_f32(x + i), vld1q_f32(dx + i), vdt));
+		vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), vld1q_f32(dy + i), vdt));
+	}
+#endif
+	IntegrateScalar(x, y, dx, dy, i, n, dt);
+}
+
+// Add ms to each frame counter; when it passes the frame length, move to
+// the next frame
+static void AdvanceFramesScalar(
+	int *counter, int *frame, const int *frameMs, const int start,
+	const int n, const int ms)
+{
+	for (int i = start; i < n; i++)
+	{
+		counter[i] += ms;
+		if (counter[i] > frameMs[i])
+		{
+			counter[i] -= frameMs[i];
+			frame[i]++;
+		}
+	}
+}
+static void AdvanceFrames(
+	int *counter, int *frame, const int *frameMs, const int n, const int ms)
+{
+	int i = 0;
+#if defined(PARTICLE_SIMD) && defined(__SSE2__)
+	const __m128i vms = _mm_set1_epi32(ms);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i c = _mm_add_epi32(
+			_mm_loadu_si128((const __m128i *)(counter + i)), vms);
+		const __m128i f = _mm_loadu_si128((const __m128i *)(frameMs + i));
+		// All ones where the frame ends
+		const __m128i m = _mm_cmpgt_epi32(c, f);
+		c = _mm_sub_epi32(c, _mm_and_si128(m, f));
+		_mm_storeu_si128((__m128i *)(counter + i), c);
+		_mm_storeu_si128(
+			(__m128i *)(frame + i),
+			_mm_sub_epi32(_mm_loadu_si128((const __m128i *)(frame + i)), m));
+	}
+#elif defined(PARTICLE_SIMD)
+	const int32x4_t vms = vdupq_n_s32(ms);
+	for (; i + 4 <= n; i += 4)
+	{
+		int32x4_t c = vaddq_s32(vld1q_s32(counter + i), vms);
+		const int32x4_t f = vld1q_s32(frameMs + i);
+		const int32x4_t m = vreinterpretq_s32_u32(vcgtq_s32(c, f));
+		c = vsubq_s32(c, vandq_s32(m, f));
+		vst1q_s32(counter + i, c);
+		vst1q_s32(frame + i, vsubq_s32(vld1q_s32(frame + i), m));
+	}
+#endif
+	AdvanceFramesScalar(counter, frame, frameMs, i, n, ms);
+}
+
+// Write the indices of the particles inside the box to out, returning how
+// many there are
+static int CullScalar(
+	const ParticleCoord *x, const ParticleCoord *y, const int start,
+	const int n, const ParticleCoord xMin, const ParticleCoord xMax,
+	const ParticleCoord yMin, const ParticleCoord yMax, int *out, int count)
+{
+	for (int i = start; i < n; i++)
+	{
+		if (x[i] >= xMin && x[i] <= xMax && y[i] >= yMin && y[i] <= yMax)
+		{
+			out[count++] = i;
+		}
+	}
+	return count;
+}
+static int Cull(
+	const ParticleCoord *x, const ParticleCoord *y, const int n,
+	const ParticleCoord xMin, const ParticleCoord xMax,
+	const ParticleCoord yMin, const ParticleCoord yMax, int *out)
+{
+	int i = 0;
+	int count = 0;
+#if defined(PARTICLE_SIMD) && defined(__SSE2__)
+	const __m128 vxMin = _mm_set1_ps(xMin);
+	const __m128 vxMax = _mm_set1_ps(xMax);
+	const __m128 vyMin = _mm_set1_ps(yMin);
+	const __m128 vyMax = _mm_set1_ps(yMax);
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 in = _mm_and_ps(
+			_mm_and_ps(_mm_cmpge_ps(vx, vxMin), _mm_cmple_ps(vx, vxMax)),
+			_mm_and_ps(_mm_cmpge_ps(vy, vyMin), _mm_cmple_ps(vy, vyMax)));
+		int mask = _mm_movemask_ps(in);
+		// Usually all or none of a group are visible
+		if (mask == 0xF)
+		{
+			out[count++] = i;
+			out[count++] = i + 1;
+			out[count++] = i + 2;
+			out[count++] = i + 3;
+			continue;
+		}
+		for (int j = i; mask != 0; j++, mask >>= 1)
+		{
+			if (mask & 1) out[count++] = j;
+		}
+	}
+#elif defined(PARTICLE_SIMD)
+	const float32x4_t vxMin = vdupq_n_f32(xMin);
+	const float32x4_t vxMax = vdupq_n_f32(xMax);
+	const float32x4_t vyMin = vdupq_n_f32(yMin);
+	const float32x4_t vyMax = vdupq_n_f32(yMax);
+	for (; i + 4 <= n; i += 4)
+	{
+		const float32x4_t vx = vld1q_f32(x + i);
+		const float32x4_t vy = vld1q_f32(y + i);
+		const uint32x4_t in = vandq_u32(
+			vandq_u32(vcgeq_f32(vx, vxMin), vcleq_f32(vx, vxMax)),
+			vandq_u32(vcgeq_f32(vy, vyMin), vcleq_f32(vy, vyMax)));
+		uint32_t lanes[4];
+		vst1q_u32(lanes, in);
+		for (int j = 0; j < 4; j++)
+		{
+			if (lanes[j]) out[count++] = i + j;
+		}
+	}
+#endif
+	return CullScalar(x, y, i, n, xMin, xMax, yMin, yMax, out, count);
+}
+
+static void ParticleRemove(ParticlePool *p, const int i);
 void ParticlesUpdate(const Uint32 ms)
 {
-	for (int i = 0; i < (int)Particles.size; i++)
+	ParticlePool *p = &Game->Particles;
+	Integrate(p->X, p->Y, p->DX, p->DY, p->Count, COORD_SECONDS(ms));
+	AdvanceFrames(p->FrameCounter, p->Frame, p->FrameMs, p->Count, (int)ms);
+	// Remove particles whose animation ended
+	for (int i = 0; i < p->Count;)
 	{
-		Particle *p = CArrayGet(&Particles, i);
-		if (!ParticleUpdate(p, ms))
+		if (p->Frame[i] == animFrames[p->Anim[i]])
 		{
-			CArrayDelete(&Particles, i);
+			ParticleRemove(p, i);
+			continue;
 		}
+		i++;
 	}
 }
-// Return whether to keep the particle
-static bool ParticleUpdate(Particle *p, const Uint32 ms)
+// Move the last particle into the removed one's place
+static void ParticleRemove(ParticlePool *p, const int i)
 {
-	p->x += p->dx * ms / 1000;
-	p->y += p->dy * ms / 1000;
-	return !AnimationUpdate(&p->anim, ms);
+	const int last = --p->Count;
+	p->X[i] = p->X[last];
+	p->Y[i] = p->Y[last];
+	p->DX[i] = p->DX[last];
+	p->DY[i] = p->DY[last];
+	p->FrameCounter[i] = p->FrameCounter[last];
+	p->Frame[i] = p->Frame[last];
+	p->FrameMs[i] = p->FrameMs[last];
+	p->Anim[i] = p->Anim[last];
+}
+
+static int visible[PARTICLE_CAPACITY];
+int ParticlesSprites(DrawSprite *sprites, const int y)
+{
+	const ParticlePool *p = &Game->Particles;
+	// Field coordinates of the screen, with a margin for the sprite size
+	const ParticleCoord margin = COORD_FROM_SCREEN(32);
+	const ParticleCoord yTop = COORD_FROM_SCREEN(SCREEN_HEIGHT - y);
+	const ParticleCoord width = COORD_FROM_SCREEN(SCREEN_WIDTH);
+	const ParticleCoord height = COORD_FROM_SCREEN(SCREEN_HEIGHT);
+	const int n = Cull(
+		p->X, p->Y, p->Count, -margin, width + margin,
+		yTop - height - margin, yTop + margin, visible);
+	for (int v = 0; v < n; v++)
+	{
+		const int i = visible[v];
+		const Animation *a = anims[p->Anim[i]];
+		const int stride = a->image->w / a->w;
+		DrawSprite *s = &sprites[v];
+		s->Surface = a->image;
+		s->Src = (SDL_Rect){
+			(Sint16)((p->Frame[i] % stride) * a->w),
+			(Sint16)((p->Frame[i] / stride) * a->h),
+			(Uint16)a->w, (Uint16)a->h
+		};
+		s->X = COORD_SCREEN_X(p->X[i]) - a->w / 2;
+		s->Y = COORD_SCREEN_Y(p->Y[i]) - a->h / 2;
+	}
+	return n;
 }
-static void ParticleDraw(const Particle *p, SDL_Surface *screen, const float y);
-void ParticlesDraw(SDL_Surface *screen, const float y)
+
+#define BENCHMARK_MS 200
+static double BenchmarkRun(
+	const bool simd, const int n, ParticleCoord *x, ParticleCoord *y,
+	ParticleCoord *dx, ParticleCoord *dy, int *counter, int *frame,
+	int *frameMs, int *out);
+void ParticlesBenchmark(void)
 {
-	for (int i = 0; i < (int)Particles.size; i++)
+#ifdef PARTICLE_SIMD
+	printf("Particle kernels, " PARTICLE_SIMD " vs scalar, ns per particle\n");
+#else
+	printf("Particle kernels, no SIMD available, ns per particle\n");
+#endif
+	printf("%10s %10s %10s %8s\n", "particles", "scalar", "simd", "speedup");
+	const int sizes[] = { 1000, 10000, 100000 };
+	for (int s = 0; s < (int)(sizeof sizes / sizeof sizes[0]); s++)
 	{
-		ParticleDraw(CArrayGet(&Particles, i), screen, y);
+		const int n = sizes[s];
+		ParticleCoord *x, *y, *dx, *dy;
+		int *counter, *frame, *frameMs, *out;
+		CMALLOC(x, n * sizeof *x);
+		CMALLOC(y, n * sizeof *y);
+		CMALLOC(dx, n * sizeof *dx);
+		CMALLOC(dy, n * sizeof *dy);
+		CMALLOC(counter, n * sizeof *counter);
+		CMALLOC(frame, n * sizeof *frame);
+		CMALLOC(frameMs, n * sizeof *frameMs);
+		CMALLOC(out, n * sizeof *out);
+		const double scalarNs = BenchmarkRun(
+			false, n, x, y, dx, dy, counter, frame, frameMs, out);
+		const double simdNs = BenchmarkRun(
+			true, n, x, y, dx, dy, counter, frame, frameMs, out);
+		printf(
+			"%10d %10.3f %10.3f %7.2fx\n",
+			n, scalarNs, simdNs, scalarNs / simdNs);
+		CFREE(x);
+		CFREE(y);
+		CFREE(dx);
+		CFREE(dy);
+		CFREE(counter);
+		CFREE(frame);
+		CFREE(frameMs);
+		CFREE(out);
 	}
 }
-static void ParticleDraw(const Particle *p, SDL_Surface *screen, const float y)
+// Run update and cull passes for a while, returning ns per particle
+static double BenchmarkRun(
+	const bool simd, const int n, ParticleCoord *x, ParticleCoord *y,
+	ParticleCoord *dx, ParticleCoord *dy, int *counter, int *frame,
+	int *frameMs, int *out)
 {
-	AnimationDraw(
-		&p->anim, screen, (int)SCREEN_X(p->x), (int)(SCREEN_Y(p->y) - y));
+	// Start from the same explosion each time, half of it on screen
+	Rng r;
+	RngSeed(&r, 1);
+	for (int i = 0; i < n; i++)
+	{
+		const float theta = RngFloat(&r) * (float)M_PI * 2;
+		x[i] = COORD(FIELD_WIDTH / 2);
+		y[i] = 0;
+		dx[i] = COORD((float)cos(theta) * 8);
+		dy[i] = COORD((float)sin(theta) * 8);
+		counter[i] = 0;
+		frame[i] = 0;
+		frameMs[i] = 50;
+	}
+	const ParticleCoord dt = COORD_SECONDS(16);
+	const ParticleCoord width = COORD(FIELD_WIDTH);
+	const ParticleCoord height = COORD(FIELD_HEIGHT);
+	int passes = 0;
+	int visibleTotal = 0;
+	const Uint32 start = SDL_GetTicks();
+	Uint32 elapsed;
+	do
+	{
+		for (int k = 0; k < 16; k++, passes++)
+		{
+			if (simd)
+			{
+				Integrate(x, y, dx, dy, n, dt);
+				AdvanceFrames(counter, frame, frameMs, n, 16);
+				visibleTotal += Cull(x, y, n, 0, width, -height, 0, out);
+			}
+			else
+			{
+				IntegrateScalar(x, y, dx, dy, 0, n, dt);
+				AdvanceFramesScalar(counter, frame, frameMs, 0, n, 16);
+				visibleTotal += CullScalar(
+					x, y, 0, n, 0, width, -height, 0, out, 0);
+			}
+		}
+		elapsed = SDL_GetTicks() - start;
+	} while (elapsed < BENCHMARK_MS);
+	UNUSED(visibleTotal);
+	return elapsed * 1e6 / ((double)passes * n);
 }
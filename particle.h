@@ -26,12 +26,41 @@ POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "animation.h"
+#include "draw.h"
+#include "fixed.h"
 
 
-extern CArray Particles;	// of Particle
+// Particles are kept in a fixed-size pool, as separate arrays per field;
+// new particles are dropped while it is full
+#define PARTICLE_CAPACITY 16384
+// Number of distinct animations that particles can use
+#define MAX_PARTICLE_ANIMS 8
+
+// Positions in field units and velocities in field units per second
+#ifdef FIXED_POINT_DRAW
+typedef Fixed ParticleCoord;
+#else
+typedef float ParticleCoord;
+#endif
+
+typedef struct
+{
+	int Count;
+	ParticleCoord X[PARTICLE_CAPACITY];
+	ParticleCoord Y[PARTICLE_CAPACITY];
+	ParticleCoord DX[PARTICLE_CAPACITY];
+	ParticleCoord DY[PARTICLE_CAPACITY];
+	int FrameCounter[PARTICLE_CAPACITY];
+	int Frame[PARTICLE_CAPACITY];
+	// Copied from the animation so that frames can be advanced in bulk
+	int FrameMs[PARTICLE_CAPACITY];
+	// Index into the shared animations
+	Uint8 Anim[PARTICLE_CAPACITY];
+} ParticlePool;
 
 void ParticlesInit(void);
 void ParticlesFree(void);
+void ParticlesClear(void);
 
 void ParticlesAdd(
 	const Animation *anim, const float x, const float y,
@@ -41,4 +70,10 @@ void ParticlesAddExplosion(
 	const float speed);
 
 void ParticlesUpdate(const Uint32 ms);
-void ParticlesDraw(SDL_Surface *screen, const float y);
+// Fill in the sprites of the particles on the screen scrolled to y, up to
+// PARTICLE_CAPACITY, and return how many
+int ParticlesSprites(DrawSprite *sprites, const int y);
+
+// Time the SIMD particle kernels against the scalar ones and print the
+// results; needs no other initialisation
+void ParticlesBenchmark(void);
@@ -27,6 +27,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <stdbool.h>
 
+#include "context.h"
 #include "game.h"
 
 
@@ -34,26 +35,27 @@ typedef struct
 {
 	float x;
 	float y;
+	// Centre on screen, before scrolling
+	int screenX;
+	int screenY;
 } Pickup;
 
 #define PICKUP_RADIUS 0.15f
 
-CArray Pickups;
-
 SDL_Surface *PickupImage = NULL;
 
 
 void PickupsInit(void)
 {
-	CArrayInit(&Pickups, sizeof(Pickup));
+	CArrayInit(&Game->Pickups, sizeof(Pickup));
 }
 void PickupsFree(void)
 {
-	CArrayTerminate(&Pickups);
+	CArrayTerminate(&Game->Pickups);
 }
 void PickupsReset(void)
 {
-	CArrayClear(&Pickups);
+	CArrayClear(&Game->Pickups);
 }
 
 void PickupsAdd(const float x, const float y)
@@ -62,27 +64,29 @@ void PickupsAdd(const float x, const float y)
 	memset(&p, 0, sizeof p);
 	p.x = x;
 	p.y = y + PICKUP_RADIUS;
-	CArrayPushBack(&Pickups, &p);
+	p.screenX = SCREEN_X(p.x);
+	p.screenY = SCREEN_Y(p.y);
+	CArrayPushBack(&Game->Pickups, &p);
 }
 
 static bool PickupCollide(
 	Pickup *p, const float x, const float y, const float r);
 bool PickupsCollide(const float x, const float y, const float r)
 {
-	for (int i = 0; i < (int)Pickups.size; i++)
+	for (int i = 0; i < (int)Game->Pickups.size; i++)
 	{
-		Pickup *p = CArrayGet(&Pickups, i);
+		Pickup *p = CArrayGet(&Game->Pickups, i);
 
 		// Remove pickups that are off the top of the screen
 		if (p->y > y + FIELD_HEIGHT * 2)
 		{
-			CArrayDelete(&Pickups, i);
+			CArrayDelete(&Game->Pickups, i);
 			continue;
 		}
 
 		if (PickupCollide(p, x, y, r))
 		{
-			CArrayDelete(&Pickups, i);
+			CArrayDelete(&Game->Pickups, i);
 			return true;
 		}
 	}
@@ -98,20 +102,21 @@ static bool PickupCollide(
 	const float r2 = rTotal * rTotal;
 	return d2 <= r2;
 }
-static void PickupDraw(const Pickup *p, SDL_Surface *screen, const float y);
-void PickupsDraw(SDL_Surface *screen, const float y)
+int PickupsSprites(DrawSprite *sprites, const int max, const int y)
 {
-	for (int i = 0; i < (int)Pickups.size; i++)
+	const int w = PickupImage->w;
+	const int h = PickupImage->h;
+	int n = 0;
+	for (int i = 0; i < (int)Game->Pickups.size && n < max; i++)
 	{
-		PickupDraw(CArrayGet(&Pickups, i), screen, y);
+		const Pickup *p = CArrayGet(&Game->Pickups, i);
+		const int top = p->screenY - h / 2;
+		if (top - y < -h || top - y >= SCREEN_HEIGHT) continue;
+		DrawSprite *s = &sprites[n++];
+		s->Surface = PickupImage;
+		s->Src = (SDL_Rect){ 0, 0, (Uint16)w, (Uint16)h };
+		s->X = p->screenX - w / 2;
+		s->Y = top;
 	}
-}
-static void PickupDraw(const Pickup *p, SDL_Surface *screen, const float y)
-{
-	SDL_Rect dest = {
-		(Sint16)(SCREEN_X(p->x) - PickupImage->w / 2),
-		(Sint16)(SCREEN_Y(p->y) - PickupImage->h / 2 - y),
-		0, 0
-	};
-	SDL_BlitSurface(PickupImage, NULL, screen, &dest);
+	return n;
 }
@@ -28,10 +28,9 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <SDL.h>
 
 #include "c_array.h"
+#include "draw.h"
 
 
-extern CArray Pickups;	// of Pickup
-
 extern SDL_Surface *PickupImage;
 
 void PickupsInit(void);
@@ -42,4 +41,6 @@ void PickupsAdd(const float x, const float y);
 
 // Only collides once, and removes the colliding pickup
 bool PickupsCollide(const float x, const float y, const float r);
-void PickupsDraw(SDL_Surface *screen, const float y);
+// Fill in the sprites of up to max pickups on the screen scrolled to y, and
+// return how many
+int PickupsSprites(DrawSprite *sprites, const int max, const int y);
@@ -25,11 +25,38 @@
 extern void InitializePlatform(void);
 
 /*
- * Advances the game by a platform-appropriate time, and returns the number of
- * milliseconds that have been skipped over.
+ * Waits for the next frame to be displayed, and returns the number of
+ * microseconds that have passed since the previous call.
  */
 extern Uint32 ToNextFrame(void);
 
+/*
+ * Paces ToNextFrame to fps frames per second, which need not be a whole
+ * number of milliseconds apart. The last spinUs microseconds of each frame
+ * are spun rather than slept, for when sleeps wake up too late; 0 sleeps
+ * all the way, which is kinder to batteries.
+ */
+extern void SetFramePacing(const double fps, const Uint32 spinUs);
+
+// Timing of the frames ended by ToNextFrame, in microseconds
+typedef struct
+{
+	Uint32 Frames;
+	// Frames that ToNextFrame was already too late to wait for
+	Uint32 Late;
+	// Time from one frame to the next
+	double MeanUs;
+	double SdUs;
+	double MinUs;
+	double MaxUs;
+	// How long after the target frames actually ended
+	double MeanOvershootUs;
+	double MaxOvershootUs;
+} FrameStats;
+
+extern const FrameStats *GetFrameStats(void);
+extern void FrameStatsReset(void);
+
 // Is???Event returns true if the specified event is used to trigger the ???
 // function.
 //   EnterGamePressing: true if the event can be used to start a game from the
@@ -37,6 +64,7 @@ extern Uint32 ToNextFrame(void);
 //   EnterGameReleasing: true if the event releases buttons from the above.
 //   ExitGame: true if the event can be used to exit the entire application.
 //   Pause: true if the event can be used to pause a game in progress.
+//   ProfilerToggle: true if the event shows or hides the profiler overlay.
 
 // Get???Prompt returns the text that can be used to describe the actions that
 // can trigger a feature on the platform.
@@ -50,3 +78,5 @@ extern const char* GetExitGamePrompt(void);
 
 extern bool IsPauseEvent(const SDL_Event* event);
 extern const char* GetPausePrompt(void);
+
+extern bool IsProfilerToggleEvent(const SDL_Event* event);
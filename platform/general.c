@@ -17,38 +17,127 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <errno.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 #include "SDL.h"
 
 #include "platform.h"
+#include "utils.h"
 
-static Uint32 LastTicks = 0;
-static Uint32 TicksElapsed = 0;
+// Frame period and how much of its end to spin, in nanoseconds
+static int64_t PeriodNs = 1000000000 / FPS;
+static int64_t SpinNs = 0;
+// When the current frame should end, and when the last one did
+static int64_t TargetNs = 0;
+static int64_t LastNs = 0;
+
+static FrameStats Stats;
+// Sums for the mean and standard deviations, in microseconds
+static double SumUs, SumSqUs, SumOvershootUs;
+
+static int64_t NowNs(void)
+{
+#ifdef _WIN32
+	return (int64_t)SDL_GetTicks() * 1000000;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static void SleepUntil(const int64_t ns)
+{
+#ifdef _WIN32
+	const int64_t now = NowNs();
+	if (ns > now)
+	{
+		SDL_Delay((Uint32)((ns - now) / 1000000));
+	}
+#else
+	const struct timespec ts = {
+		(time_t)(ns / 1000000000), (long)(ns % 1000000000)
+	};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+	{
+	}
+#endif
+}
 
 void InitializePlatform(void)
 {
-	LastTicks = SDL_GetTicks();
+	LastNs = TargetNs = NowNs();
+	FrameStatsReset();
+}
+
+void SetFramePacing(const double fps, const Uint32 spinUs)
+{
+	PeriodNs = (int64_t)(1000000000 / fps);
+	SpinNs = (int64_t)spinUs * 1000;
 }
 
 Uint32 ToNextFrame(void)
 {
-	const Uint32 duration = 1000 / FPS;
-	for (;;)
+	TargetNs += PeriodNs;
+	const int64_t before = NowNs();
+	if (before > TargetNs)
 	{
-		Uint32 Ticks = SDL_GetTicks();
-		TicksElapsed += Ticks - LastTicks;
-		LastTicks = Ticks;
-		if (TicksElapsed <= duration)
+		Stats.Late++;
+		// More than a frame behind; start again from now rather than
+		// rushing the next frames to catch up
+		if (before - TargetNs > PeriodNs)
 		{
-			SDL_Delay(1);
-			continue;
+			TargetNs = before;
 		}
-		break;
 	}
-	TicksElapsed -= duration;
-	return duration;
+	else
+	{
+		// Sleep until shortly before the end of the frame, then spin the
+		// rest, as sleeps can wake up late
+		if (TargetNs - before > SpinNs)
+		{
+			SleepUntil(TargetNs - SpinNs);
+		}
+		while (NowNs() < TargetNs)
+		{
+		}
+	}
+	const int64_t now = NowNs();
+	const double us = (now - LastNs) / 1000.0;
+	LastNs = now;
+
+	if (Stats.Frames == 0 || us < Stats.MinUs) Stats.MinUs = us;
+	if (us > Stats.MaxUs) Stats.MaxUs = us;
+	Stats.Frames++;
+	SumUs += us;
+	SumSqUs += us * us;
+	const double overshootUs = MAX(now - TargetNs, 0) / 1000.0;
+	SumOvershootUs += overshootUs;
+	Stats.MaxOvershootUs = MAX(Stats.MaxOvershootUs, overshootUs);
+	return (Uint32)(us + 0.5);
+}
+
+const FrameStats *GetFrameStats(void)
+{
+	if (Stats.Frames > 0)
+	{
+		Stats.MeanUs = SumUs / Stats.Frames;
+		Stats.SdUs = sqrt(MAX(
+			SumSqUs / Stats.Frames - Stats.MeanUs * Stats.MeanUs, 0.0));
+		Stats.MeanOvershootUs = SumOvershootUs / Stats.Frames;
+	}
+	return &Stats;
+}
+
+void FrameStatsReset(void)
+{
+	memset(&Stats, 0, sizeof Stats);
+	SumUs = SumSqUs = SumOvershootUs = 0;
 }
 
 bool IsEnterGamePressingEvent(const SDL_Event* event)
@@ -92,3 +181,9 @@ const char* GetPausePrompt(void)
 {
 	return "P";
 }
+
+bool IsProfilerToggleEvent(const SDL_Event* event)
+{
+	return event->type == SDL_KEYDOWN
+	    && event->key.keysym.sym == SDLK_F1;
+}
@@ -17,21 +17,65 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "SDL.h"
 
 #include "platform.h"
+#include "utils.h"
+
+static Uint32 LastTicks = 0;
+
+static FrameStats Stats;
+// Sums for the mean and standard deviation, in microseconds
+static double SumUs, SumSqUs;
 
 void InitializePlatform(void)
 {
+	LastTicks = SDL_GetTicks();
+	FrameStatsReset();
+}
+
+void SetFramePacing(const double fps, const Uint32 spinUs)
+{
+	// OpenDingux paces frames by vertical sync.
+	UNUSED(fps);
+	UNUSED(spinUs);
 }
 
 Uint32 ToNextFrame(void)
 {
 	// OpenDingux waits for vertical sync by itself.
-	return 16;
+	const Uint32 Ticks = SDL_GetTicks();
+	const double us = (Ticks - LastTicks) * 1000.0;
+	LastTicks = Ticks;
+
+	if (Stats.Frames == 0 || us < Stats.MinUs) Stats.MinUs = us;
+	if (us > Stats.MaxUs) Stats.MaxUs = us;
+	Stats.Frames++;
+	SumUs += us;
+	SumSqUs += us * us;
+	return (Uint32)us;
+}
+
+const FrameStats *GetFrameStats(void)
+{
+	if (Stats.Frames > 0)
+	{
+		Stats.MeanUs = SumUs / Stats.Frames;
+		Stats.SdUs = sqrt(MAX(
+			SumSqUs / Stats.Frames - Stats.MeanUs * Stats.MeanUs, 0.0));
+	}
+	return &Stats;
+}
+
+void FrameStatsReset(void)
+{
+	memset(&Stats, 0, sizeof Stats);
+	SumUs = SumSqUs = 0;
 }
 
 bool IsEnterGamePressingEvent(const SDL_Event* event)
@@ -73,3 +117,9 @@ const char* GetPausePrompt(void)
 {
 	return "Start";
 }
+
+bool IsProfilerToggleEvent(const SDL_Event* event)
+{
+	return event->type == SDL_KEYDOWN
+	    && event->key.keysym.sym == SDLK_TAB /* L */;
+}
@@ -2,12 +2,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "context.h"
 #include "draw.h"
 #include "game.h"
 #include "init.h"
 #include "main.h"
 #include "particle.h"
 #include "player.h"
+#include "rng.h"
 #include "space.h"
 #include "sound.h"
 #include "utils.h"
@@ -16,19 +18,97 @@
 #define PLAYER_SPRITESHEET_COUNT 16
 #define PLAYER_ROLL_SCALE 0.015f
 #define PLAYER_BLINK_FRAME_OFFSET 16
-#define PLAYER_BLINK_FRAMES 20
-#define PLAYER_BLINK_INTERVAL_FRAMES ((rand() % 100) + 100)
+#define PLAYER_BLINK_MS 320
+#define PLAYER_BLINK_INTERVAL_MS (RngInt(&Game->Rngs[RNG_BLINK], 1600) + 1600)
 #define PLAYER_BLINK_CHANCE 50
 #define PLAYER_RESPAWN_COUNTER 0
 #define PLAYER_TAIL_COUNTER 20
+// Start positions are laid out in rows of at most this many players, which
+// keeps them apart by a little more than a diameter
+#define PLAYER_ROW_MAX 10
+#define PLAYER_ROW_SPACING (PLAYER_RADIUS * 3)
 
-SDL_Surface* PlayerSpritesheets[MAX_PLAYERS];
+SDL_Surface* PlayerSpritesheets[PLAYER_SPRITESHEETS];
 Animation Spark;
 Animation SparkRed;
 Animation Tail;
 Mix_Chunk* SoundPlayerBounce = NULL;
 
-Player players[MAX_PLAYERS];
+static void SummaryReset(PlayerSummary *s);
+static void SummaryAddEnabled(PlayerSummary *s, const int i);
+static void SummaryAddAlive(PlayerSummary *s, const float y);
+void PlayersSync(void)
+{
+	PlayerState *ps = &Game->PlayerState;
+	PlayerSummary *s = &ps->Summary;
+	SummaryReset(s);
+	for (int i = 0; i < ps->Count; i++)
+	{
+		ps->PrevX[i] = ps->X[i];
+		ps->PrevY[i] = ps->Y[i];
+		if (ps->Alive[i])
+		{
+			const cpBody *body = Game->Players[i].Body;
+			const cpVect pos = cpBodyGetPosition(body);
+			const cpVect vel = cpBodyGetVelocity(body);
+			ps->X[i] = (float)pos.x;
+			ps->Y[i] = (float)pos.y;
+			ps->VX[i] = (float)vel.x;
+			ps->VY[i] = (float)vel.y;
+			SummaryAddAlive(s, ps->Y[i]);
+		}
+		SummaryAddEnabled(s, i);
+	}
+	s->MiddleY = s->sumY / s->NumAlive;
+	s->stale = false;
+}
+const PlayerSummary *PlayersGetSummary(void)
+{
+	PlayerState *ps = &Game->PlayerState;
+	PlayerSummary *s = &ps->Summary;
+	if (s->stale)
+	{
+		SummaryReset(s);
+		for (int i = 0; i < ps->Count; i++)
+		{
+			if (ps->Alive[i])
+			{
+				SummaryAddAlive(s, ps->Y[i]);
+			}
+			SummaryAddEnabled(s, i);
+		}
+		s->MiddleY = s->sumY / s->NumAlive;
+		s->stale = false;
+	}
+	return s;
+}
+static void SummaryReset(PlayerSummary *s)
+{
+	s->MinY = NAN;
+	s->MaxY = NAN;
+	s->NumAlive = 0;
+	s->NumEnabled = 0;
+	s->EnabledMinY = NAN;
+	s->sumY = 0;
+}
+static void SummaryAddEnabled(PlayerSummary *s, const int i)
+{
+	const PlayerState *ps = &Game->PlayerState;
+	if (!ps->Enabled[i]) return;
+	// The bodies of dead players stay where they died, while their Y moves
+	// to where they respawn
+	const float y = ps->Alive[i] ?
+		ps->Y[i] : (float)cpBodyGetPosition(Game->Players[i].Body).y;
+	if (s->NumEnabled == 0 || y < s->EnabledMinY) s->EnabledMinY = y;
+	s->NumEnabled++;
+}
+static void SummaryAddAlive(PlayerSummary *s, const float y)
+{
+	if (s->NumAlive == 0 || y < s->MinY) s->MinY = y;
+	if (s->NumAlive == 0 || y > s->MaxY) s->MaxY = y;
+	s->sumY += y;
+	s->NumAlive++;
+}
 
 typedef struct
 {
@@ -38,7 +118,9 @@ typedef struct
 static void OnArbiter(cpBody *body, cpArbiter *arb, void *data);
 void PlayerUpdate(Player *player, const Uint32 ms)
 {
-	if (!player->Enabled) return;
+	PlayerState *ps = &Game->PlayerState;
+	const int i = player->Index;
+	if (!ps->Enabled[i]) return;
 
 	if (player->RespawnCounter > 0)
 	{
@@ -49,7 +131,7 @@ void PlayerUpdate(Player *player, const Uint32 ms)
 		}
 	}
 
-	if (!player->Alive) return;
+	if (!ps->Alive[i]) return;
 
 	// Update the speed at which the player is going.
 	// Provide positive bonus for:
@@ -58,12 +140,12 @@ void PlayerUpdate(Player *player, const Uint32 ms)
 	// And negative bonus for:
 	// - when the player is above max speed
 	float accel = ACCELERATION;
-	const cpVect vel = cpBodyGetVelocity(player->Body);
-	const float relVelX = (float)fabs(vel.x) * SIGN(vel.x * player->AccelX);
+	const float vx = ps->VX[i];
+	const float relVelX = fabsf(vx) * SIGN(vx * ps->AccelX[i]);
 	if (relVelX > MAX_SPEED) accel = ACCELERATION_MAX_SPEED;
 	if (relVelX < MIN_SPEED) accel += MIN_SPEED_ACCEL_BONUS;
 	if (player->WasOnSurface) accel += ROLL_ACCEL_BONUS;
-	cpBodySetForce(player->Body, cpv(player->AccelX / 32767.0f * accel, 0));
+	cpBodySetForce(player->Body, cpv(ps->AccelX[i] / 32767.0f * accel, 0));
 	//printf("%f\n", vel.x);
 
 	// Detect bounces
@@ -79,14 +161,14 @@ void PlayerUpdate(Player *player, const Uint32 ms)
 		{
 			float angularV = (float)cpBodyGetAngularVelocity(player->Body);
 			//printf("angularV %f\n", angularV);
-			SoundPlayRoll(player->Index, angularV);
+			SoundPlayRoll(i, angularV);
 		}
 		player->WasOnSurface = true;
 		player->ScoredInAir = false;
 	}
 	else
 	{
-		SoundStopRoll(player->Index);
+		SoundStopRoll(i);
 		player->WasOnSurface = false;
 	}
 
@@ -95,12 +177,12 @@ void PlayerUpdate(Player *player, const Uint32 ms)
 	if (player->Roll < 0) player->Roll += PLAYER_SPRITESHEET_COUNT;
 
 	// Randomly blink after not blinking for a while
-	player->BlinkCounter--;
-	player->NextBlinkCounter--;
+	player->BlinkCounter -= ms;
+	player->NextBlinkCounter -= ms;
 	if (player->NextBlinkCounter <= 0)
 	{
-		player->BlinkCounter = PLAYER_BLINK_FRAMES;
-		player->NextBlinkCounter = PLAYER_BLINK_INTERVAL_FRAMES;
+		player->BlinkCounter = PLAYER_BLINK_MS;
+		player->NextBlinkCounter = PLAYER_BLINK_INTERVAL_MS;
 	}
 
 	// Leave a tail
@@ -108,12 +190,8 @@ void PlayerUpdate(Player *player, const Uint32 ms)
 	if (player->TailCounter <= 0)
 	{
 		player->TailCounter = PLAYER_TAIL_COUNTER;
-		ParticlesAdd(&Tail, player->x, player->y, 0, 0);
+		ParticlesAdd(&Tail, ps->X[i], ps->Y[i], 0, 0);
 	}
-
-	const cpVect pos = cpBodyGetPosition(player->Body);
-	player->x = (float)pos.x;
-	player->y = (float)pos.y;
 }
 static void OnArbiter(cpBody *body, cpArbiter *arb, void *data)
 {
@@ -123,9 +201,11 @@ static void OnArbiter(cpBody *body, cpArbiter *arb, void *data)
 	o->Num++;
 }
 
-void PlayerDraw(const Player *player, const float y)
+bool PlayerSprite(const Player *player, DrawSprite *sprite)
 {
-	if (!player->Enabled) return;
+	const PlayerState *ps = &Game->PlayerState;
+	const int i = player->Index;
+	if (!ps->Enabled[i]) return false;
 
 	// Draw the character.
 	int rollFrame = player->Roll;
@@ -133,56 +213,79 @@ void PlayerDraw(const Player *player, const float y)
 	{
 		rollFrame += PLAYER_BLINK_FRAME_OFFSET;
 	}
-	SDL_Rect src = {
+	sprite->Surface = player->Sprites;
+	sprite->Src = (SDL_Rect){
 		(Sint16)((rollFrame % PLAYER_SPRITESHEET_STRIDE) * PLAYER_SPRITESHEET_WIDTH),
 		(Sint16)((rollFrame / PLAYER_SPRITESHEET_STRIDE) * PLAYER_SPRITESHEET_HEIGHT),
 		PLAYER_SPRITESHEET_WIDTH,
 		PLAYER_SPRITESHEET_HEIGHT
 	};
-
-	SDL_Rect dest = {
-		(Sint16)(SCREEN_X(player->x) - PLAYER_SPRITESHEET_WIDTH / 2),
-		(Sint16)(SCREEN_Y(player->y) - PLAYER_SPRITESHEET_HEIGHT / 2 - y),
-		0,
-		0
-	};
-	SDL_BlitSurface(player->Sprites, &src, Screen, &dest);
+	sprite->X = SCREEN_X(DrawLerp(ps->PrevX[i], ps->X[i])) -
+		PLAYER_SPRITESHEET_WIDTH / 2;
+	sprite->Y = SCREEN_Y(DrawLerp(ps->PrevY[i], ps->Y[i])) -
+		PLAYER_SPRITESHEET_HEIGHT / 2;
+	return true;
+}
+void PlayerDraw(const Player *player, const int y)
+{
+	DrawSprite sprite;
+	if (PlayerSprite(player, &sprite))
+	{
+		DRAW_Sprite(&sprite, Screen, y);
+	}
 }
 
 void PlayerInit(Player *player, const int i, const cpVect pos)
 {
+	PlayerState *ps = &Game->PlayerState;
 	player->Index = i;
-	player->Enabled = true;
-	player->Alive = true;
+	ps->Enabled[i] = true;
+	ps->Alive[i] = true;
+	ps->Summary.stale = true;
 	player->RespawnCounter = 0;
 	player->Score = 0;
 	player->Body = cpSpaceAddBody(
-		space.Space,
+		Game->Space.Space,
 		cpBodyNew(10.0f, cpMomentForCircle(10.0f, 0.0f, PLAYER_RADIUS, cpvzero)));
 	cpBodySetPosition(player->Body, pos);
+	ps->X[i] = ps->PrevX[i] = (float)pos.x;
+	ps->Y[i] = ps->PrevY[i] = (float)pos.y;
+	ps->VX[i] = 0;
+	ps->VY[i] = 0;
 	cpShape *shape = cpSpaceAddShape(
-		space.Space, cpCircleShapeNew(player->Body, PLAYER_RADIUS, cpvzero));
+		Game->Space.Space, cpCircleShapeNew(player->Body, PLAYER_RADIUS, cpvzero));
 	cpShapeSetElasticity(shape, PLAYER_ELASTICITY);
 	cpShapeSetFriction(shape, 0.9f);
-	player->AccelX = 0;
+	ps->AccelX[i] = 0;
 	player->WasOnSurface = false;
 	player->ScoredInAir = false;
 	player->Roll = 0;
 	player->BlinkCounter = 0;
 	player->NextBlinkCounter = 1;
 	player->TailCounter = PLAYER_TAIL_COUNTER;
-	player->Sprites = PlayerSpritesheets[i];
+	player->Sprites = PlayerSpritesheets[i % PLAYER_SPRITESHEETS];
 }
 
 void PlayerReset(Player *player, const int i)
 {
 	player->Score = 0;
-	if (!player->Enabled) return;
-	cpBody *body = player->Body;
-	cpBodySetPosition(body, cpv(
-		(i + 1) * FIELD_WIDTH / (PlayerAliveCount() + 1),
-		FIELD_HEIGHT * 0.75f));
-	cpBodySetVelocity(body, cpvzero);
+	// The physics space has been rebuilt, so the old body is gone
+	if (!Game->PlayerState.Enabled[player->Index])
+	{
+		player->Body = NULL;
+		return;
+	}
+	PlayerInit(player, player->Index, PlayerStartPosition(
+		i, PlayerAliveCount(), FIELD_HEIGHT * 0.75f));
+}
+
+cpVect PlayerStartPosition(const int i, const int n, const float y)
+{
+	const int row = i / PLAYER_ROW_MAX;
+	const int rowCount = MIN(n - row * PLAYER_ROW_MAX, PLAYER_ROW_MAX);
+	return cpv(
+		(i % PLAYER_ROW_MAX + 1) * FIELD_WIDTH / (rowCount + 1),
+		y + row * PLAYER_ROW_SPACING);
 }
 
 void PlayerScore(Player *player, const bool air)
@@ -192,7 +295,7 @@ void PlayerScore(Player *player, const bool air)
 	// Add sparks at player position
 	ParticlesAddExplosion(
 		(air && player->ScoredInAir) ? &SparkRed : &Spark,
-		player->x, player->y, 100, 2.5f);
+		Game->PlayerState.X[player->Index], Game->PlayerState.Y[player->Index], 100, 2.5f);
 	if (air)
 	{
 		player->ScoredInAir = true;
@@ -202,11 +305,13 @@ void PlayerScore(Player *player, const bool air)
 
 void PlayerKill(Player *player)
 {
-	if (player->Alive)
+	bool *alive = &Game->PlayerState.Alive[player->Index];
+	if (*alive)
 	{
 		SoundPlay(SoundLose, 1.0);
+		Game->PlayerState.Summary.stale = true;
 	}
-	player->Alive = false;
+	*alive = false;
 	player->RespawnCounter = PLAYER_RESPAWN_COUNTER;
 	// This ensures drawing the player with eyes closed
 	player->BlinkCounter = 1;
@@ -215,27 +320,37 @@ void PlayerKill(Player *player)
 
 void PlayerRespawn(Player *player, const float x, const float y)
 {
-	player->x = x;
-	player->y = y;
+	PlayerState *ps = &Game->PlayerState;
+	ps->X[player->Index] = ps->PrevX[player->Index] = x;
+	ps->Y[player->Index] = ps->PrevY[player->Index] = y;
 	player->RespawnCounter = -1;
 }
 
 void PlayerRevive(Player *player)
 {
-	player->Alive = true;
+	PlayerState *ps = &Game->PlayerState;
+	const int i = player->Index;
+	// The body moves from where the player died, which may have been the
+	// enabled minimum
+	if (!ps->Alive[i])
+	{
+		ps->Summary.stale = true;
+	}
+	ps->Alive[i] = true;
 	SoundPlay(SoundStart, 1.0);
 	// Reset body to cached position
-	cpBodySetPosition(player->Body, cpv(player->x, player->y));
+	cpBodySetPosition(player->Body, cpv(ps->X[i], ps->Y[i]));
 	cpBodySetVelocity(player->Body, cpvzero);
+	ps->VX[i] = 0;
+	ps->VY[i] = 0;
 }
 
 int PlayerAliveCount(void)
 {
 	int num = 0;
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < Game->PlayerState.Count; i++)
 	{
-		if (!players[i].Alive) continue;
-		num++;
+		num += Game->PlayerState.Alive[i];
 	}
 	return num;
 }
@@ -243,10 +358,9 @@ int PlayerAliveCount(void)
 int PlayerEnabledCount(void)
 {
 	int num = 0;
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < Game->PlayerState.Count; i++)
 	{
-		if (!players[i].Enabled) continue;
-		num++;
+		num += Game->PlayerState.Enabled[i];
 	}
 	return num;
 }
@@ -7,26 +7,71 @@
 #include <SDL_mixer.h>
 
 #include "animation.h"
+#include "draw.h"
 
 
+// Most players can have, human or bot
+#define MAX_PLAYERS 64
+// The first players are controlled by GetMovement, the rest by the bot
+#define MAX_HUMAN_PLAYERS 2
+#define DEFAULT_PLAYERS 2
+
+// Summary of all players, gathered in the same pass that syncs them after
+// each physics step and kept up to date as players die and revive
 typedef struct
 {
-	int Index;
+	// Over the live players; NaN if there are none
+	float MinY;
+	float MiddleY;
+	float MaxY;
+	int NumAlive;
+	int NumEnabled;
+	// Over the enabled players' bodies, those of dead players included;
+	// players await reviving until someone is past this. NaN if none
+	float EnabledMinY;
+
+	// Sum of the live players' Y, for the mean
+	float sumY;
+	// A player died since the summary was made; their Y can't just be
+	// taken out of the min and max, so the summary is made again when next
+	// needed
+	bool stale;
+} PlayerSummary;
+
+// State of all players that is read or written every frame, in parallel
+// arrays indexed by player so that passes over all players stay compact
+typedef struct
+{
+	// Number of players in use
+	int Count;
 
 	// Whether the player is in the game or not
-	bool Enabled;
-	bool Alive;
+	bool Enabled[MAX_PLAYERS];
+	bool Alive[MAX_PLAYERS];
+
+	// Position and velocity of live players after the last physics step;
+	// once dead, X and Y are where the player is drawn and revived
+	float X[MAX_PLAYERS], Y[MAX_PLAYERS];
+	// X and Y before the last physics step, to draw between the two
+	float PrevX[MAX_PLAYERS], PrevY[MAX_PLAYERS];
+	float VX[MAX_PLAYERS], VY[MAX_PLAYERS];
+
+	// The last value returned by GetMovement.
+	int16_t AccelX[MAX_PLAYERS];
+
+	PlayerSummary Summary;
+} PlayerState;
+
+typedef struct
+{
+	int Index;
+
 	// Once dead, wait this long before respawning
 	int RespawnCounter;
 
 	int Score;
 
 	cpBody *Body;
-	// Cached positions for drawing only
-	float x, y;
-
-	// The last value returned by GetMovement.
-	int16_t AccelX;
 
 	// Used to detect rolling for rolling sound
 	bool WasOnSurface;
@@ -48,23 +93,31 @@ typedef struct
 	SDL_Surface *Sprites;
 } Player;
 
-#define MAX_PLAYERS 2
-extern Player players[MAX_PLAYERS];
-
 #define PLAYER_SPRITESHEET_WIDTH 35
 #define PLAYER_SPRITESHEET_HEIGHT 35
 
-extern SDL_Surface* PlayerSpritesheets[MAX_PLAYERS];
+// Players take turns using the spritesheets
+#define PLAYER_SPRITESHEETS 2
+extern SDL_Surface* PlayerSpritesheets[PLAYER_SPRITESHEETS];
 extern Animation Spark;
 extern Animation SparkRed;
 extern Animation Tail;
 extern Mix_Chunk* SoundPlayerBounce;
 extern int SoundPlayerRollChannel;
 
+// Copy the bodies of live players into playerState after a physics step,
+// and summarise them
+void PlayersSync(void);
+const PlayerSummary *PlayersGetSummary(void);
 void PlayerUpdate(Player *player, const Uint32 ms);
-void PlayerDraw(const Player *player, const float y);
+// Where and how the player is drawn, between their positions before and
+// after the last step; false if they aren't in the game
+bool PlayerSprite(const Player *player, DrawSprite *sprite);
+void PlayerDraw(const Player *player, const int y);
 void PlayerInit(Player *player, const int i, const cpVect pos);
 void PlayerReset(Player *player, const int i);
+// Where the i'th of n players starts, in rows going up from y
+cpVect PlayerStartPosition(const int i, const int n, const float y);
 
 void PlayerScore(Player *player, const bool air);
 void PlayerKill(Player *player);
@@ -0,0 +1,190 @@
+#include "profiler.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "init.h"
+#include "utils.h"
+
+// Number of frames kept in the rolling history
+#define PROFILER_HISTORY 64
+// Histogram buckets double in size, starting from this many microseconds
+#define PROFILER_BUCKET_US 16
+#define PROFILER_BUCKETS 12
+#define PROFILER_BUCKET_W 4
+// Width of the bar showing the average share of a 60 FPS frame
+#define PROFILER_FRAME_US 16667
+#define PROFILER_BAR_W 40
+#define PROFILER_ROW_H 9
+#define PROFILER_LABEL_W 64
+
+bool ProfilerEnabled = false;
+TTF_Font *profilerFont = NULL;
+
+static const char *labels[PROFILER_COUNT] =
+{
+	"input", "physics", "players", "space", "particles",
+	"draw bg", "draw gaps", "draw pickups", "draw particles",
+	"draw players", "draw hud", "flip"
+};
+static SDL_Surface *labelSurfaces[PROFILER_COUNT];
+
+static THREAD_LOCAL uint32_t startUs[PROFILER_COUNT];
+static THREAD_LOCAL bool running[PROFILER_COUNT];
+static THREAD_LOCAL uint32_t frameUs[PROFILER_COUNT];
+// Only touched by the thread drawing the frames
+static uint16_t history[PROFILER_COUNT][PROFILER_HISTORY];
+static int historyIndex = 0;
+// Set by ProfilerToggle for the drawing thread to clear the history
+static bool reset = false;
+
+static uint32_t NowUs(void)
+{
+#ifdef _WIN32
+	return SDL_GetTicks() * 1000;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#endif
+}
+
+static bool Enabled(void)
+{
+	return __atomic_load_n(&ProfilerEnabled, __ATOMIC_RELAXED);
+}
+
+void ProfilerToggle(void)
+{
+	// Start with a clean history each time
+	memset(running, 0, sizeof running);
+	memset(frameUs, 0, sizeof frameUs);
+	__atomic_store_n(&reset, true, __ATOMIC_RELAXED);
+	__atomic_store_n(&ProfilerEnabled, !Enabled(), __ATOMIC_RELAXED);
+}
+void ProfilerFree(void)
+{
+	for (int i = 0; i < PROFILER_COUNT; i++)
+	{
+		SDL_FreeSurface(labelSurfaces[i]);
+		labelSurfaces[i] = NULL;
+	}
+}
+
+void ProfilerBegin(const ProfilerPhase p)
+{
+	if (!Enabled()) return;
+	startUs[p] = NowUs();
+	running[p] = true;
+}
+void ProfilerEnd(const ProfilerPhase p)
+{
+	if (!running[p]) return;
+	frameUs[p] += NowUs() - startUs[p];
+	running[p] = false;
+}
+void ProfilerFrameTake(uint32_t us[PROFILER_COUNT])
+{
+	memcpy(us, frameUs, sizeof frameUs);
+	memset(frameUs, 0, sizeof frameUs);
+}
+void ProfilerFrameEnd(const uint32_t *us)
+{
+	if (!Enabled()) return;
+	if (__atomic_exchange_n(&reset, false, __ATOMIC_RELAXED))
+	{
+		// This thread's times may be from before the toggle
+		memset(frameUs, 0, sizeof frameUs);
+		memset(history, 0, sizeof history);
+		historyIndex = 0;
+		return;
+	}
+	for (int i = 0; i < PROFILER_COUNT; i++)
+	{
+		const uint32_t total = frameUs[i] + (us != NULL ? us[i] : 0);
+		history[i][historyIndex] = (uint16_t)MIN(total, 65535);
+		frameUs[i] = 0;
+	}
+	historyIndex = (historyIndex + 1) % PROFILER_HISTORY;
+}
+
+static void DrawRow(SDL_Surface *s, const int i, const int y);
+void ProfilerDraw(SDL_Surface *s)
+{
+	if (!Enabled()) return;
+	const int h = PROFILER_ROW_H * PROFILER_COUNT;
+	SDL_Rect bg =
+	{
+		0, (Sint16)(SCREEN_HEIGHT - h),
+		PROFILER_LABEL_W + PROFILER_BUCKETS * PROFILER_BUCKET_W +
+		PROFILER_BAR_W + 4,
+		(Uint16)h
+	};
+	SDL_FillRect(s, &bg, SDL_MapRGB(s->format, 0, 0, 0));
+	for (int i = 0; i < PROFILER_COUNT; i++)
+	{
+		DrawRow(s, i, bg.y + i * PROFILER_ROW_H);
+	}
+}
+static void DrawRow(SDL_Surface *s, const int i, const int y)
+{
+	// Labels are rendered once
+	if (labelSurfaces[i] == NULL && profilerFont != NULL)
+	{
+		const SDL_Color white = { 255, 255, 255, 255 };
+		labelSurfaces[i] =
+			TTF_RenderText_Blended(profilerFont, labels[i], white);
+	}
+	if (labelSurfaces[i] != NULL)
+	{
+		SDL_Rect src = { 0, 0, PROFILER_LABEL_W - 2, PROFILER_ROW_H };
+		SDL_Rect dest = { 1, (Sint16)y, 0, 0 };
+		SDL_BlitSurface(labelSurfaces[i], &src, s, &dest);
+	}
+
+	// Histogram of frame times; green under 1 ms, yellow under 4 ms
+	int counts[PROFILER_BUCKETS];
+	memset(counts, 0, sizeof counts);
+	uint32_t total = 0;
+	for (int j = 0; j < PROFILER_HISTORY; j++)
+	{
+		const uint32_t us = history[i][j];
+		total += us;
+		int b = 0;
+		while (b < PROFILER_BUCKETS - 1 &&
+			us >= (uint32_t)(PROFILER_BUCKET_US << b))
+		{
+			b++;
+		}
+		counts[b]++;
+	}
+	for (int b = 0; b < PROFILER_BUCKETS; b++)
+	{
+		if (counts[b] == 0) continue;
+		const int bh =
+			MAX(1, counts[b] * (PROFILER_ROW_H - 1) / PROFILER_HISTORY);
+		const uint32_t bucketUs = (uint32_t)(PROFILER_BUCKET_US << b);
+		const Uint32 c = bucketUs < 1000 ? SDL_MapRGB(s->format, 0, 200, 0) :
+			bucketUs < 4000 ? SDL_MapRGB(s->format, 220, 200, 0) :
+			SDL_MapRGB(s->format, 220, 0, 0);
+		SDL_Rect r =
+		{
+			(Sint16)(PROFILER_LABEL_W + b * PROFILER_BUCKET_W),
+			(Sint16)(y + PROFILER_ROW_H - 1 - bh),
+			PROFILER_BUCKET_W - 1, (Uint16)bh
+		};
+		SDL_FillRect(s, &r, c);
+	}
+
+	// Average share of the frame budget
+	const uint32_t avgUs = total / PROFILER_HISTORY;
+	SDL_Rect bar =
+	{
+		(Sint16)(PROFILER_LABEL_W + PROFILER_BUCKETS * PROFILER_BUCKET_W + 2),
+		(Sint16)(y + 2),
+		(Uint16)MIN(
+			PROFILER_BAR_W, avgUs * PROFILER_BAR_W / PROFILER_FRAME_US + 1),
+		PROFILER_ROW_H - 4
+	};
+	SDL_FillRect(s, &bar, SDL_MapRGB(s->format, 80, 160, 255));
+}
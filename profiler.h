@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+// Per-frame timing of the main loop phases, with an on-screen overlay.
+// Each phase's time is summed over the frame, and a rolling history of the
+// last frames is drawn as a histogram per phase.
+// Each thread times its own phases; the thread that draws a frame owns the
+// history, and the times of phases run elsewhere are handed to it.
+
+typedef enum
+{
+	PROFILER_INPUT,
+	PROFILER_PHYSICS,
+	PROFILER_PLAYERS,
+	PROFILER_SPACE,
+	PROFILER_PARTICLES,
+	PROFILER_DRAW_BG,
+	PROFILER_DRAW_GAPS,
+	PROFILER_DRAW_PICKUPS,
+	PROFILER_DRAW_PARTICLES,
+	PROFILER_DRAW_PLAYERS,
+	PROFILER_DRAW_HUD,
+	PROFILER_FLIP,
+	PROFILER_COUNT
+} ProfilerPhase;
+
+// Timing only happens while the overlay is shown
+extern bool ProfilerEnabled;
+extern TTF_Font *profilerFont;
+
+void ProfilerToggle(void);
+void ProfilerFree(void);
+
+void ProfilerBegin(const ProfilerPhase p);
+void ProfilerEnd(const ProfilerPhase p);
+// Move this thread's times for the frame into us, to hand to the thread
+// that draws the frame
+void ProfilerFrameTake(uint32_t us[PROFILER_COUNT]);
+// Move this thread's times for the frame, plus those taken on another
+// thread if not NULL, into the history
+void ProfilerFrameEnd(const uint32_t *us);
+
+void ProfilerDraw(SDL_Surface *s);
@@ -0,0 +1,226 @@
+#include "render.h"
+
+#include <stdio.h>
+
+#include "bg.h"
+#include "context.h"
+#include "game.h"
+#include "main.h"
+#include "profiler.h"
+#include "text.h"
+#include "utils.h"
+
+// Set on the index of the snapshot in between until it has been taken
+#define RENDER_FRESH 4
+
+// The snapshot being filled in by the logic, the one being drawn, and the
+// newest whole one in between; each side swaps its own with the one in
+// between, so neither ever waits for the other
+static RenderSnapshot snapshots[3];
+static int back = 0;
+static int front = 1;
+static int ready = 2;
+// Set while the render thread draws its snapshot; cleared under idleLock
+static int drawing = 0;
+static int quit = 0;
+
+static SDL_Thread *thread = NULL;
+// Posted each time a snapshot is made ready for a render thread that has
+// taken the last one
+static SDL_sem *readySem = NULL;
+static SDL_mutex *videoLock = NULL;
+// Signalled under idleLock each time the render thread finishes drawing
+static SDL_mutex *idleLock = NULL;
+static SDL_cond *idleCond = NULL;
+
+static int RenderThread(void *data);
+void RenderStart(void)
+{
+	quit = 0;
+	readySem = SDL_CreateSemaphore(0);
+	videoLock = SDL_CreateMutex();
+	idleLock = SDL_CreateMutex();
+	idleCond = SDL_CreateCond();
+	if (readySem != NULL && videoLock != NULL &&
+		idleLock != NULL && idleCond != NULL)
+	{
+		thread = SDL_CreateThread(RenderThread, Game);
+	}
+	if (thread == NULL)
+	{
+		printf(
+			"Error: cannot start render thread, drawing on the main "
+			"thread: %s\n", SDL_GetError());
+		RenderStop();
+	}
+}
+void RenderStop(void)
+{
+	if (thread != NULL)
+	{
+		RenderWaitIdle();
+		__atomic_store_n(&quit, 1, __ATOMIC_RELEASE);
+		SDL_SemPost(readySem);
+		SDL_WaitThread(thread, NULL);
+		thread = NULL;
+	}
+	if (readySem != NULL)
+	{
+		SDL_DestroySemaphore(readySem);
+		readySem = NULL;
+	}
+	if (videoLock != NULL)
+	{
+		SDL_DestroyMutex(videoLock);
+		videoLock = NULL;
+	}
+	if (idleLock != NULL)
+	{
+		SDL_DestroyMutex(idleLock);
+		idleLock = NULL;
+	}
+	if (idleCond != NULL)
+	{
+		SDL_DestroyCond(idleCond);
+		idleCond = NULL;
+	}
+}
+
+RenderSnapshot *RenderBegin(void)
+{
+	return &snapshots[back];
+}
+
+static void Draw(const RenderSnapshot *r);
+void RenderSubmit(void)
+{
+	if (thread == NULL)
+	{
+		Draw(&snapshots[back]);
+		return;
+	}
+	const int last =
+		__atomic_exchange_n(&ready, back | RENDER_FRESH, __ATOMIC_SEQ_CST);
+	// If the render thread hadn't taken the last snapshot it is dropped
+	// and filled in again, and the thread has already been woken for it
+	back = last & ~RENDER_FRESH;
+	if (!(last & RENDER_FRESH))
+	{
+		SDL_SemPost(readySem);
+	}
+}
+
+void RenderWaitIdle(void)
+{
+	if (thread == NULL) return;
+	// The render thread marks itself drawing before taking the snapshot,
+	// so once it is taken, drawing shows whether it is done; it is only
+	// cleared under the lock, so the signal can't come between the check
+	// and the wait
+	SDL_LockMutex(idleLock);
+	while ((__atomic_load_n(&ready, __ATOMIC_SEQ_CST) & RENDER_FRESH) ||
+		__atomic_load_n(&drawing, __ATOMIC_SEQ_CST))
+	{
+		SDL_CondWait(idleCond, idleLock);
+	}
+	SDL_UnlockMutex(idleLock);
+}
+
+int RenderPollEvent(SDL_Event *ev)
+{
+	if (videoLock == NULL)
+	{
+		return SDL_PollEvent(ev);
+	}
+	SDL_LockMutex(videoLock);
+	const int polled = SDL_PollEvent(ev);
+	SDL_UnlockMutex(videoLock);
+	return polled;
+}
+
+static int RenderThread(void *data)
+{
+	// The background draws from the context's background RNG, which
+	// nothing else uses during games
+	Game = data;
+	for (;;)
+	{
+		SDL_SemWait(readySem);
+		if (__atomic_load_n(&quit, __ATOMIC_ACQUIRE)) break;
+		__atomic_store_n(&drawing, 1, __ATOMIC_SEQ_CST);
+		front = __atomic_exchange_n(&ready, front, __ATOMIC_SEQ_CST) &
+			~RENDER_FRESH;
+		Draw(&snapshots[front]);
+		SDL_LockMutex(idleLock);
+		__atomic_store_n(&drawing, 0, __ATOMIC_SEQ_CST);
+		SDL_CondBroadcast(idleCond);
+		SDL_UnlockMutex(idleLock);
+	}
+	return 0;
+}
+
+static void DrawSprites(const DrawSprite *sprites, const int n, const int y);
+static void DrawScores(const RenderSnapshot *r);
+static void Draw(const RenderSnapshot *r)
+{
+	// Draw the background.
+	ProfilerBegin(PROFILER_DRAW_BG);
+	DrawBackground(&BG, r->Y);
+	ProfilerEnd(PROFILER_DRAW_BG);
+
+	ProfilerBegin(PROFILER_DRAW_GAPS);
+	DrawSprites(r->Blocks, r->NumBlocks, r->Y);
+	ProfilerEnd(PROFILER_DRAW_GAPS);
+	ProfilerBegin(PROFILER_DRAW_PICKUPS);
+	DrawSprites(r->Pickups, r->NumPickups, r->Y);
+	ProfilerEnd(PROFILER_DRAW_PICKUPS);
+	ProfilerBegin(PROFILER_DRAW_PARTICLES);
+	DrawSprites(r->Particles, r->NumParticles, r->Y);
+	ProfilerEnd(PROFILER_DRAW_PARTICLES);
+
+	ProfilerBegin(PROFILER_DRAW_PLAYERS);
+	DrawSprites(r->Players, r->NumPlayers, r->Y);
+	ProfilerEnd(PROFILER_DRAW_PLAYERS);
+
+	ProfilerBegin(PROFILER_DRAW_HUD);
+	DrawScores(r);
+	ProfilerEnd(PROFILER_DRAW_HUD);
+
+	ProfilerDraw(Screen);
+	ProfilerBegin(PROFILER_FLIP);
+	if (videoLock != NULL) SDL_LockMutex(videoLock);
+	SDL_Flip(Screen);
+	if (videoLock != NULL) SDL_UnlockMutex(videoLock);
+	ProfilerEnd(PROFILER_FLIP);
+	ProfilerFrameEnd(r->ProfileUs);
+}
+static void DrawSprites(const DrawSprite *sprites, const int n, const int y)
+{
+	for (int i = 0; i < n; i++)
+	{
+		DRAW_Sprite(&sprites[i], Screen, y);
+	}
+}
+static void DrawScores(const RenderSnapshot *r)
+{
+	for (int i = 0; i < r->NumScores; i++)
+	{
+		// Draw each player's current score.
+		char buf[17];
+		sprintf(buf, "%d", r->Scores[i]);
+		const SDL_Color white = { 255, 255, 255, 255 };
+		const int w = TextAtlasWidth(&fontAtlas, buf);
+		const int x = (i + 1) * SCREEN_WIDTH / (r->NumScores + 1);
+		const int wHalf = (w + PLAYER_SPRITESHEET_WIDTH) / 2;
+		// Draw the player icon, followed by the score number
+		SDL_Rect src = {
+			0, 0, PLAYER_SPRITESHEET_WIDTH, PLAYER_SPRITESHEET_HEIGHT
+		};
+		SDL_Rect dest = { (Sint16)(x - wHalf), 0, 0, 0 };
+		SDL_BlitSurface(r->ScoreSprites[i], &src, Screen, &dest);
+		// Draw score number
+		TextAtlasDraw(
+			&fontAtlas, Screen, buf, x - wHalf + PLAYER_SPRITESHEET_WIDTH,
+			(PLAYER_SPRITESHEET_HEIGHT - TTF_FontHeight(font)) / 2, white);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL.h>
+
+#include "draw.h"
+#include "particle.h"
+#include "player.h"
+#include "profiler.h"
+#include "space.h"
+
+// Most player scores shown along the top of the screen
+#define HUD_MAX_SCORES 6
+// Most pickups drawn at once
+#define RENDER_MAX_PICKUPS 64
+
+// Everything needed to draw a frame of the game, copied out of the game
+// state after the logic so that it can be drawn while the logic goes on
+typedef struct
+{
+	// Screen Y of the top of the screen, that the sprites scroll up by
+	int Y;
+	int NumBlocks;
+	DrawSprite Blocks[SPACE_MAX_BLOCKS];
+	int NumPickups;
+	DrawSprite Pickups[RENDER_MAX_PICKUPS];
+	int NumParticles;
+	DrawSprite Particles[PARTICLE_CAPACITY];
+	int NumPlayers;
+	DrawSprite Players[MAX_PLAYERS];
+	// Scores along the top, each with the player's first sprite
+	int NumScores;
+	SDL_Surface *ScoreSprites[HUD_MAX_SCORES];
+	int Scores[HUD_MAX_SCORES];
+	// Profiler times of the phases run by the logic for this frame
+	uint32_t ProfileUs[PROFILER_COUNT];
+} RenderSnapshot;
+
+// Draw snapshots on a thread of their own, rather than as they are
+// submitted; call before the first frame
+void RenderStart(void);
+// Wait for the render thread, if any, to draw what it has and stop it
+void RenderStop(void);
+
+// The snapshot to fill in for the next frame
+RenderSnapshot *RenderBegin(void);
+// Draw the snapshot from RenderBegin, or hand it to the render thread
+void RenderSubmit(void);
+// Wait until the render thread has drawn every snapshot; the caller may
+// then draw to the screen itself
+void RenderWaitIdle(void);
+
+// SDL 1.2 can't pump events while another thread flips the screen, so
+// events are polled through here, under the lock that the render thread
+// flips under
+int RenderPollEvent(SDL_Event *ev);
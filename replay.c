@@ -0,0 +1,171 @@
+#include "replay.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+// File layout, all integers little-endian:
+//   "FTRP", version (u8), player count (u8), enabled (u8 per player),
+//   seed (u32)
+// followed by one record per frame:
+//   flags (u8), milliseconds (u8), AccelX (s16 per player) if flagged
+#define REPLAY_MAGIC "FTRP"
+#define REPLAY_VERSION 2
+#define REPLAY_FLAG_PAUSE 0x01
+#define REPLAY_FLAG_EXIT 0x02
+#define REPLAY_FLAG_INPUT 0x04
+
+Replay replay;
+
+static void WriteU16(FILE *f, const uint16_t v);
+static void WriteU32(FILE *f, const uint32_t v);
+static bool ReadU16(FILE *f, uint16_t *v);
+static bool ReadU32(FILE *f, uint32_t *v);
+
+void ReplayInit(Replay *r, const ReplayMode mode, const char *filename)
+{
+	memset(r, 0, sizeof *r);
+	r->Mode = mode;
+	r->Filename = filename;
+}
+void ReplayEnd(Replay *r)
+{
+	if (r->f != NULL)
+	{
+		fclose(r->f);
+		r->f = NULL;
+	}
+}
+
+bool ReplayRecordStart(
+	Replay *r, const uint32_t seed, const int count, const bool *enabled)
+{
+	ReplayEnd(r);
+	r->f = fopen(r->Filename, "wb");
+	if (r->f == NULL)
+	{
+		printf("Error: cannot open replay file %s\n", r->Filename);
+		return false;
+	}
+	r->Seed = seed;
+	r->Count = count;
+	memcpy(r->Enabled, enabled, count * sizeof r->Enabled[0]);
+	memset(&r->last, 0, sizeof r->last);
+
+	fwrite(REPLAY_MAGIC, 1, strlen(REPLAY_MAGIC), r->f);
+	fputc(REPLAY_VERSION, r->f);
+	fputc(r->Count, r->f);
+	for (int i = 0; i < r->Count; i++)
+	{
+		fputc(r->Enabled[i] ? 1 : 0, r->f);
+	}
+	WriteU32(r->f, r->Seed);
+	return true;
+}
+void ReplayRecordFrame(Replay *r, const ReplayFrame *f)
+{
+	if (r->f == NULL) return;
+	const bool inputChanged =
+		memcmp(f->AccelX, r->last.AccelX, r->Count * sizeof f->AccelX[0]) != 0;
+	uint8_t flags = 0;
+	if (f->Pause) flags |= REPLAY_FLAG_PAUSE;
+	if (f->Exit) flags |= REPLAY_FLAG_EXIT;
+	if (inputChanged) flags |= REPLAY_FLAG_INPUT;
+	fputc(flags, r->f);
+	fputc((int)MIN(f->Ms, 255), r->f);
+	if (inputChanged)
+	{
+		for (int i = 0; i < r->Count; i++)
+		{
+			WriteU16(r->f, (uint16_t)f->AccelX[i]);
+		}
+	}
+	r->last = *f;
+}
+
+bool ReplayPlayStart(Replay *r)
+{
+	ReplayEnd(r);
+	r->f = fopen(r->Filename, "rb");
+	if (r->f == NULL)
+	{
+		printf("Error: cannot open replay file %s\n", r->Filename);
+		return false;
+	}
+	char magic[sizeof REPLAY_MAGIC - 1];
+	if (fread(magic, 1, sizeof magic, r->f) != sizeof magic ||
+		memcmp(magic, REPLAY_MAGIC, sizeof magic) != 0 ||
+		fgetc(r->f) != REPLAY_VERSION)
+	{
+		printf("Error: %s is not a compatible replay\n", r->Filename);
+		ReplayEnd(r);
+		return false;
+	}
+	r->Count = fgetc(r->f);
+	if (r->Count < 1 || r->Count > MAX_PLAYERS)
+	{
+		printf("Error: %s has an unsupported player count\n", r->Filename);
+		ReplayEnd(r);
+		return false;
+	}
+	for (int i = 0; i < r->Count; i++)
+	{
+		r->Enabled[i] = fgetc(r->f) == 1;
+	}
+	if (!ReadU32(r->f, &r->Seed))
+	{
+		printf("Error: %s is truncated\n", r->Filename);
+		ReplayEnd(r);
+		return false;
+	}
+	memset(&r->last, 0, sizeof r->last);
+	return true;
+}
+bool ReplayPlayFrame(Replay *r, ReplayFrame *f)
+{
+	if (r->f == NULL) return false;
+	const int flags = fgetc(r->f);
+	const int ms = fgetc(r->f);
+	if (flags == EOF || ms == EOF) return false;
+	*f = r->last;
+	f->Pause = (flags & REPLAY_FLAG_PAUSE) != 0;
+	f->Exit = (flags & REPLAY_FLAG_EXIT) != 0;
+	f->Ms = (uint32_t)ms;
+	if (flags & REPLAY_FLAG_INPUT)
+	{
+		for (int i = 0; i < r->Count; i++)
+		{
+			uint16_t v;
+			if (!ReadU16(r->f, &v)) return false;
+			f->AccelX[i] = (int16_t)v;
+		}
+	}
+	r->last = *f;
+	return true;
+}
+
+static void WriteU16(FILE *f, const uint16_t v)
+{
+	fputc(v & 0xff, f);
+	fputc(v >> 8, f);
+}
+static void WriteU32(FILE *f, const uint32_t v)
+{
+	WriteU16(f, (uint16_t)(v & 0xffff));
+	WriteU16(f, (uint16_t)(v >> 16));
+}
+static bool ReadU16(FILE *f, uint16_t *v)
+{
+	const int lo = fgetc(f);
+	const int hi = fgetc(f);
+	if (lo == EOF || hi == EOF) return false;
+	*v = (uint16_t)(lo | (hi << 8));
+	return true;
+}
+static bool ReadU32(FILE *f, uint32_t *v)
+{
+	uint16_t lo, hi;
+	if (!ReadU16(f, &lo) || !ReadU16(f, &hi)) return false;
+	*v = lo | ((uint32_t)hi << 16);
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "player.h"
+
+// Recording and playback of the inputs of a single game.
+// A replay holds the RNG seed, player count and enabled players at the start
+// of the game, then one record per logic frame; feeding the records back into
+// the game logic reproduces the game exactly.
+
+typedef enum
+{
+	REPLAY_MODE_NONE,
+	REPLAY_MODE_RECORD,
+	REPLAY_MODE_PLAY
+} ReplayMode;
+
+typedef struct
+{
+	int16_t AccelX[MAX_PLAYERS];
+	// Pause was toggled this frame
+	bool Pause;
+	bool Exit;
+	// Duration of the logic frame
+	uint32_t Ms;
+} ReplayFrame;
+
+typedef struct
+{
+	ReplayMode Mode;
+	const char *Filename;
+	FILE *f;
+
+	uint32_t Seed;
+	int Count;
+	bool Enabled[MAX_PLAYERS];
+
+	// Previous frame; inputs are only stored when they change
+	ReplayFrame last;
+} Replay;
+
+extern Replay replay;
+
+void ReplayInit(Replay *r, const ReplayMode mode, const char *filename);
+void ReplayEnd(Replay *r);
+
+// Start recording a new game, overwriting the previous recording
+bool ReplayRecordStart(
+	Replay *r, const uint32_t seed, const int count, const bool *enabled);
+void ReplayRecordFrame(Replay *r, const ReplayFrame *f);
+
+// Open the recording and read its seed, player count and enabled players
+bool ReplayPlayStart(Replay *r);
+// Returns false at the end of the recording
+bool ReplayPlayFrame(Replay *r, ReplayFrame *f);
@@ -0,0 +1,58 @@
+#include "rng.h"
+
+#include "context.h"
+
+static uint32_t SplitMix32(uint32_t *x);
+
+void RngSeedAll(const uint32_t seed)
+{
+	uint32_t x = seed;
+	for (int i = 0; i < RNG_COUNT; i++)
+	{
+		RngSeed(&Game->Rngs[i], SplitMix32(&x));
+	}
+}
+
+void RngSeed(Rng *r, uint32_t seed)
+{
+	// Expand the seed so that the state is never all zeros
+	for (int i = 0; i < 4; i++)
+	{
+		r->s[i] = SplitMix32(&seed);
+	}
+}
+
+#define ROTL(_x, _k) (((_x) << (_k)) | ((_x) >> (32 - (_k))))
+uint32_t RngNext(Rng *r)
+{
+	uint32_t *s = r->s;
+	const uint32_t result = ROTL(s[1] * 5, 7) * 9;
+	const uint32_t t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = ROTL(s[3], 11);
+	return result;
+}
+
+int RngInt(Rng *r, const int n)
+{
+	// Multiply-shift instead of modulo; no bias toward low values
+	return (int)(((uint64_t)RngNext(r) * (uint32_t)n) >> 32);
+}
+
+float RngFloat(Rng *r)
+{
+	// Top 24 bits fit exactly in a float's mantissa
+	return (float)(RngNext(r) >> 8) * (1.0f / 16777216.0f);
+}
+
+static uint32_t SplitMix32(uint32_t *x)
+{
+	uint32_t z = (*x += 0x9e3779b9);
+	z = (z ^ (z >> 16)) * 0x85ebca6b;
+	z = (z ^ (z >> 13)) * 0xc2b2ae35;
+	return z ^ (z >> 16);
+}
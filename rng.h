@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+// Small seedable random number generator (xoshiro128**).
+// Each subsystem draws from its own stream, so that e.g. cosmetic effects
+// don't change how levels are generated.
+
+typedef struct
+{
+	uint32_t s[4];
+} Rng;
+
+typedef enum
+{
+	RNG_GAPS,	// gap layout and pickups
+	RNG_RESPAWN,	// where dead players come back
+	RNG_BLOCKS,	// block skins
+	RNG_BACKGROUND,
+	RNG_BLINK,
+	RNG_PARTICLES,
+	RNG_COUNT
+} RngStream;
+
+// Seed all the streams from a single seed
+void RngSeedAll(const uint32_t seed);
+
+void RngSeed(Rng *r, uint32_t seed);
+uint32_t RngNext(Rng *r);
+// Uniform integer in [0, n)
+int RngInt(Rng *r, const int n);
+// Uniform float in [0, 1)
+float RngFloat(Rng *r);
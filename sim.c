@@ -0,0 +1,220 @@
+#include "sim.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "context.h"
+#include "game.h"
+#include "gap.h"
+#include "main.h"
+#include "player.h"
+#include "title.h"
+#include "utils.h"
+
+#if SIM_OBS_OPENINGS != MAX_GAPS
+#error "SIM_OBS_OPENINGS must match MAX_GAPS"
+#endif
+
+struct Sim
+{
+	int Instances;
+	int Players;
+	uint32_t Seed;
+	GameContext *Games;
+	// Games each instance has started, for the restart seeds
+	uint32_t *Episodes;
+	// Each instance's game over count when its current game started
+	int *GamesOver;
+};
+
+
+Sim *SimNew(const int instances, const int players, const bool headless)
+{
+	if (instances < 1 || players < 1 || players > MAX_PLAYERS)
+	{
+		printf(
+			"Error: cannot simulate %d instances of %d players\n",
+			instances, players);
+		return NULL;
+	}
+	Sim *s = calloc(1, sizeof *s);
+	if (s == NULL) return NULL;
+	s->Instances = instances;
+	s->Players = players;
+	s->Games = malloc(instances * sizeof *s->Games);
+	s->Episodes = calloc(instances, sizeof *s->Episodes);
+	s->GamesOver = calloc(instances, sizeof *s->GamesOver);
+	if (s->Games == NULL || s->Episodes == NULL || s->GamesOver == NULL)
+	{
+		printf("Error: cannot allocate %d game instances\n", instances);
+		free(s->Games);
+		free(s->Episodes);
+		free(s->GamesOver);
+		free(s);
+		return NULL;
+	}
+	for (int i = 0; i < instances; i++)
+	{
+		GameContextInit(&s->Games[i], players, headless);
+	}
+	return s;
+}
+void SimFree(Sim *s)
+{
+	if (s == NULL) return;
+	for (int i = 0; i < s->Instances; i++)
+	{
+		GameContextFree(&s->Games[i]);
+	}
+	free(s->Games);
+	free(s->Episodes);
+	free(s->GamesOver);
+	free(s);
+}
+
+int SimObsSize(const Sim *s)
+{
+	return 1 + s->Players * SIM_OBS_PLAYER + SIM_OBS_GAPS * SIM_OBS_GAP;
+}
+
+static void StartGame(Sim *s, const int i);
+static void Observe(const Sim *s, float *obs);
+void SimReset(Sim *s, const uint32_t seed, float *obs)
+{
+	GameContext *prev = Game;
+	s->Seed = seed;
+	const int obsSize = SimObsSize(s);
+	for (int i = 0; i < s->Instances; i++)
+	{
+		Game = &s->Games[i];
+		s->Episodes[i] = 0;
+		StartGame(s, i);
+		Observe(s, obs + i * obsSize);
+	}
+	Game = prev;
+}
+static void StartGame(Sim *s, const int i)
+{
+	Game->Seed = s->Seed + i + s->Instances * s->Episodes[i];
+	s->Episodes[i]++;
+	s->GamesOver[i] = Game->GamesOver;
+	// Skip the title screen, with every player in
+	bool enabled[MAX_PLAYERS];
+	for (int j = 0; j < s->Players; j++)
+	{
+		enabled[j] = true;
+	}
+	ToTitleScreen(true);
+	TitleScreenStartGame(enabled);
+}
+
+void SimStep(
+	Sim *s, const float *actions, float *obs, float *rewards, uint8_t *dones)
+{
+	GameContext *prev = Game;
+	const int obsSize = SimObsSize(s);
+	for (int i = 0; i < s->Instances; i++)
+	{
+		Game = &s->Games[i];
+		PlayerState *ps = &Game->PlayerState;
+		const float *a = actions + i * s->Players;
+		int scores[MAX_PLAYERS];
+		for (int j = 0; j < s->Players; j++)
+		{
+			ps->AccelX[j] = (int16_t)CLAMP(a[j] * 32767, -32768, 32767);
+			scores[j] = Game->Players[j].Score;
+		}
+
+		bool cont = true;
+		bool error = false;
+		Game->DoLogic(&cont, &error, HEADLESS_FRAME_MS);
+
+		// Game over resets the players, so their scores are in the result
+		const bool done = Game->GamesOver != s->GamesOver[i];
+		if (rewards != NULL)
+		{
+			for (int j = 0; j < s->Players; j++)
+			{
+				const int score = done ?
+					Game->LastResult.Scores[j] : Game->Players[j].Score;
+				rewards[i * s->Players + j] = (float)(score - scores[j]);
+			}
+		}
+		if (dones != NULL)
+		{
+			dones[i] = done;
+		}
+		if (done)
+		{
+			StartGame(s, i);
+		}
+		Observe(s, obs + i * obsSize);
+	}
+	Game = prev;
+}
+
+static void ObserveGap(const struct Gap *g, float *obs);
+static void Observe(const Sim *s, float *obs)
+{
+	const PlayerState *ps = &Game->PlayerState;
+	*obs++ = Game->Camera.Y;
+	for (int i = 0; i < s->Players; i++)
+	{
+		*obs++ = ps->X[i];
+		*obs++ = ps->Y[i];
+		*obs++ = ps->VX[i];
+		*obs++ = ps->VY[i];
+		*obs++ = ps->Alive[i] ? 1.0f : 0.0f;
+	}
+
+	// Gaps are kept from top to bottom; skip those above every live player
+	const float maxY = PlayersGetSummary()->MaxY;
+	int first = 0;
+	if (!isnan(maxY))
+	{
+		while (first < Game->Space.NumGaps &&
+			SpaceGap(&Game->Space, first)->Y > maxY + PLAYER_RADIUS)
+		{
+			first++;
+		}
+	}
+	for (int i = 0; i < SIM_OBS_GAPS; i++)
+	{
+		if (first + i < Game->Space.NumGaps)
+		{
+			ObserveGap(SpaceGap(&Game->Space, first + i), obs);
+		}
+		else
+		{
+			obs[0] = Game->Camera.Y - FIELD_HEIGHT / 2;
+			obs[1] = 0;
+			obs[2] = FIELD_WIDTH;
+			for (int j = 3; j < SIM_OBS_GAP; j++)
+			{
+				obs[j] = 0;
+			}
+		}
+		obs += SIM_OBS_GAP;
+	}
+}
+static void ObserveGap(const struct Gap *g, float *obs)
+{
+	*obs++ = g->Y;
+	// Openings are between neighbouring blocks; blocks are centred on X
+	for (int i = 0; i < SIM_OBS_OPENINGS; i++)
+	{
+		if (i + 1 < g->numBlocks)
+		{
+			const Block *bl = &g->blocks[i];
+			const Block *br = &g->blocks[i + 1];
+			*obs++ = bl->X + bl->W / 2;
+			*obs++ = br->X - br->W / 2;
+		}
+		else
+		{
+			*obs++ = 0;
+			*obs++ = 0;
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Vectorised environment for training and evaluating bots: steps several
+// game instances together, running only the game logic, with fixed
+// HEADLESS_FRAME_MS frames. Needs no video, audio or SDL initialisation,
+// nor any of the game's data files, so it can be driven from a test harness
+// linking the game sources (without main.c) or `make sim`; sim_nosdl.c
+// stands in for the SDL libraries where they aren't wanted.
+//
+// A Sim and its instances belong to the thread that made it; use one Sim
+// per thread to spread instances over cores.
+//
+// The observation of an instance is SimObsSize floats:
+//   camera Y
+//   for each player: X, Y, VX, VY, alive (1 or 0)
+//   for each of the next SIM_OBS_GAPS gap layers below the highest live
+//   player: Y, then SIM_OBS_OPENINGS (left X, right X) openings, left to
+//   right; unused openings are empty, at 0. Missing layers have Y at the
+//   bottom of the screen and one opening across the whole field.
+// Observations of all instances are contiguous, instance after instance.
+// The field is 5.33 units wide; Y increases upwards, and the camera Y is
+// the middle of the screen, which scrolls down after the players.
+
+#define SIM_OBS_GAPS 3
+// As MAX_GAPS in game.h
+#define SIM_OBS_OPENINGS 3
+#define SIM_OBS_PLAYER 5
+#define SIM_OBS_GAP (1 + SIM_OBS_OPENINGS * 2)
+
+typedef struct Sim Sim;
+
+// players is 1 to MAX_PLAYERS. Headless instances play no sound; pass
+// false only once SDL and the sounds are set up, as by the game itself.
+// Returns NULL on failure
+Sim *SimNew(const int instances, const int players, const bool headless);
+void SimFree(Sim *s);
+
+// Floats of observation per instance
+int SimObsSize(const Sim *s);
+
+// Start a new game in every instance, instance k seeded with seed + k;
+// writes the first observations to obs
+void SimReset(Sim *s, const uint32_t seed, float *obs);
+
+// Step every instance by one frame. actions holds one movement per player
+// per instance, from -1 (left) to 1 (right); dead players' are ignored.
+// Writes the new observations to obs, and if not NULL, each player's score
+// gained this step to rewards (also one per player per instance) and to
+// dones whether the instance's game ended this step. Ended games start over
+// by themselves with the next seed, seed + k + instances * n for the nth
+// restart, and obs has the first observation of the new game.
+void SimStep(
+	Sim *s, const float *actions, float *obs, float *rewards, uint8_t *dones);
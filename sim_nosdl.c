@@ -0,0 +1,345 @@
+// Stand-ins for the SDL, SDL_image, SDL_mixer and SDL_ttf functions that
+// the game sources call, so that a harness driving sim.h can link without
+// the SDL libraries. Built into its own library by `make sim`; link it
+// instead of the SDL libraries, never along with them.
+//
+// sim.h only runs the game logic, and headless instances never reach the
+// video or audio, so these only have to fail cleanly: everything that
+// makes something returns NULL or an error, and SDL_Init fails so that
+// Initialize stops early if it is called anyway.
+
+#include <time.h>
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_mixer.h>
+#include <SDL_ttf.h>
+
+#include "utils.h"
+
+static char error[] = "SDL is not linked";
+
+int SDL_Init(Uint32 flags)
+{
+	UNUSED(flags);
+	return -1;
+}
+void SDL_Quit(void) {}
+char *SDL_GetError(void)
+{
+	return error;
+}
+void SDL_ClearError(void) {}
+Uint32 SDL_GetTicks(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (Uint32)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+SDL_mutex *SDL_CreateMutex(void)
+{
+	return NULL;
+}
+void SDL_DestroyMutex(SDL_mutex *mutex)
+{
+	UNUSED(mutex);
+}
+int SDL_mutexP(SDL_mutex *mutex)
+{
+	UNUSED(mutex);
+	return -1;
+}
+int SDL_mutexV(SDL_mutex *mutex)
+{
+	UNUSED(mutex);
+	return -1;
+}
+SDL_sem *SDL_CreateSemaphore(Uint32 initial_value)
+{
+	UNUSED(initial_value);
+	return NULL;
+}
+void SDL_DestroySemaphore(SDL_sem *sem)
+{
+	UNUSED(sem);
+}
+int SDL_SemWait(SDL_sem *sem)
+{
+	UNUSED(sem);
+	return -1;
+}
+int SDL_SemPost(SDL_sem *sem)
+{
+	UNUSED(sem);
+	return -1;
+}
+SDL_cond *SDL_CreateCond(void)
+{
+	return NULL;
+}
+void SDL_DestroyCond(SDL_cond *cond)
+{
+	UNUSED(cond);
+}
+int SDL_CondWait(SDL_cond *cond, SDL_mutex *mut)
+{
+	UNUSED(cond);
+	UNUSED(mut);
+	return -1;
+}
+int SDL_CondBroadcast(SDL_cond *cond)
+{
+	UNUSED(cond);
+	return -1;
+}
+SDL_Thread *SDL_CreateThread(int (*fn)(void *), void *data)
+{
+	UNUSED(fn);
+	UNUSED(data);
+	return NULL;
+}
+void SDL_WaitThread(SDL_Thread *thread, int *status)
+{
+	UNUSED(thread);
+	UNUSED(status);
+}
+
+SDL_Surface *SDL_SetVideoMode(int width, int height, int bpp, Uint32 flags)
+{
+	UNUSED(width);
+	UNUSED(height);
+	UNUSED(bpp);
+	UNUSED(flags);
+	return NULL;
+}
+SDL_Surface *SDL_GetVideoSurface(void)
+{
+	return NULL;
+}
+void SDL_WM_SetCaption(const char *title, const char *icon)
+{
+	UNUSED(title);
+	UNUSED(icon);
+}
+void SDL_WM_SetIcon(SDL_Surface *icon, Uint8 *mask)
+{
+	UNUSED(icon);
+	UNUSED(mask);
+}
+int SDL_ShowCursor(int toggle)
+{
+	UNUSED(toggle);
+	return 0;
+}
+int SDL_PollEvent(SDL_Event *event)
+{
+	UNUSED(event);
+	return 0;
+}
+int SDL_Flip(SDL_Surface *screen)
+{
+	UNUSED(screen);
+	return -1;
+}
+
+SDL_Surface *SDL_CreateRGBSurface(
+	Uint32 flags, int width, int height, int depth,
+	Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask)
+{
+	UNUSED(flags);
+	UNUSED(width);
+	UNUSED(height);
+	UNUSED(depth);
+	UNUSED(Rmask);
+	UNUSED(Gmask);
+	UNUSED(Bmask);
+	UNUSED(Amask);
+	return NULL;
+}
+SDL_Surface *SDL_DisplayFormat(SDL_Surface *surface)
+{
+	UNUSED(surface);
+	return NULL;
+}
+SDL_Surface *SDL_DisplayFormatAlpha(SDL_Surface *surface)
+{
+	UNUSED(surface);
+	return NULL;
+}
+void SDL_FreeSurface(SDL_Surface *surface)
+{
+	UNUSED(surface);
+}
+int SDL_LockSurface(SDL_Surface *surface)
+{
+	UNUSED(surface);
+	return -1;
+}
+void SDL_UnlockSurface(SDL_Surface *surface)
+{
+	UNUSED(surface);
+}
+int SDL_SetColorKey(SDL_Surface *surface, Uint32 flag, Uint32 key)
+{
+	UNUSED(surface);
+	UNUSED(flag);
+	UNUSED(key);
+	return -1;
+}
+int SDL_SetAlpha(SDL_Surface *surface, Uint32 flag, Uint8 alpha)
+{
+	UNUSED(surface);
+	UNUSED(flag);
+	UNUSED(alpha);
+	return -1;
+}
+Uint32 SDL_MapRGB(
+	const SDL_PixelFormat * const format,
+	const Uint8 r, const Uint8 g, const Uint8 b)
+{
+	UNUSED(format);
+	UNUSED(r);
+	UNUSED(g);
+	UNUSED(b);
+	return 0;
+}
+int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	UNUSED(dst);
+	UNUSED(dstrect);
+	UNUSED(color);
+	return -1;
+}
+int SDL_UpperBlit(
+	SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	UNUSED(src);
+	UNUSED(srcrect);
+	UNUSED(dst);
+	UNUSED(dstrect);
+	return -1;
+}
+SDL_RWops *SDL_RWFromFile(const char *file, const char *mode)
+{
+	UNUSED(file);
+	UNUSED(mode);
+	return NULL;
+}
+
+SDL_Surface *IMG_Load(const char *file)
+{
+	UNUSED(file);
+	return NULL;
+}
+
+int Mix_OpenAudio(int frequency, Uint16 format, int channels, int chunksize)
+{
+	UNUSED(frequency);
+	UNUSED(format);
+	UNUSED(channels);
+	UNUSED(chunksize);
+	return -1;
+}
+Mix_Chunk *Mix_LoadWAV_RW(SDL_RWops *src, int freesrc)
+{
+	UNUSED(src);
+	UNUSED(freesrc);
+	return NULL;
+}
+Mix_Music *Mix_LoadMUS(const char *file)
+{
+	UNUSED(file);
+	return NULL;
+}
+void Mix_FreeChunk(Mix_Chunk *chunk)
+{
+	UNUSED(chunk);
+}
+void Mix_FreeMusic(Mix_Music *music)
+{
+	UNUSED(music);
+}
+int Mix_PlayChannelTimed(int channel, Mix_Chunk *chunk, int loops, int ticks)
+{
+	UNUSED(channel);
+	UNUSED(chunk);
+	UNUSED(loops);
+	UNUSED(ticks);
+	return -1;
+}
+int Mix_HaltChannel(int channel)
+{
+	UNUSED(channel);
+	return 0;
+}
+int Mix_Volume(int channel, int volume)
+{
+	UNUSED(channel);
+	UNUSED(volume);
+	return 0;
+}
+int Mix_PlayMusic(Mix_Music *music, int loops)
+{
+	UNUSED(music);
+	UNUSED(loops);
+	return -1;
+}
+int Mix_VolumeMusic(int volume)
+{
+	UNUSED(volume);
+	return 0;
+}
+
+int TTF_Init(void)
+{
+	return -1;
+}
+TTF_Font *TTF_OpenFont(const char *file, int ptsize)
+{
+	UNUSED(file);
+	UNUSED(ptsize);
+	return NULL;
+}
+void TTF_CloseFont(TTF_Font *font)
+{
+	UNUSED(font);
+}
+int TTF_FontHeight(const TTF_Font *font)
+{
+	UNUSED(font);
+	return 0;
+}
+int TTF_FontAscent(const TTF_Font *font)
+{
+	UNUSED(font);
+	return 0;
+}
+int TTF_GlyphMetrics(
+	TTF_Font *font, Uint16 ch,
+	int *minx, int *maxx, int *miny, int *maxy, int *advance)
+{
+	UNUSED(font);
+	UNUSED(ch);
+	UNUSED(minx);
+	UNUSED(maxx);
+	UNUSED(miny);
+	UNUSED(maxy);
+	UNUSED(advance);
+	return -1;
+}
+SDL_Surface *TTF_RenderText_Blended(
+	TTF_Font *font, const char *text, SDL_Color fg)
+{
+	UNUSED(font);
+	UNUSED(text);
+	UNUSED(fg);
+	return NULL;
+}
+SDL_Surface *TTF_RenderGlyph_Blended(TTF_Font *font, Uint16 ch, SDL_Color fg)
+{
+	UNUSED(font);
+	UNUSED(ch);
+	UNUSED(fg);
+	return NULL;
+}
@@ -2,13 +2,18 @@
 
 #include <math.h>
 
+#include "context.h"
+#include "main.h"
 #include "player.h"
 #include "utils.h"
 
 #define BOUNCE_SPEED_MAX_VOLUME 150.0f
 #define BOUNCE_SPEED_MIN_VOLUME 10.0f
 #define ROLL_SPEED_MAX_VOLUME 20.0f
-static int rollChannels[MAX_PLAYERS];
+// Only the first players get a rolling sound, so that crowds of bots don't
+// take every mixer channel
+#define MAX_ROLL_CHANNELS MAX_HUMAN_PLAYERS
+static int rollChannels[MAX_ROLL_CHANNELS];
 
 #define MUSIC_VOLUME_LOW 24
 #define MUSIC_VOLUME_HIGH 64
@@ -29,7 +34,7 @@ bool SoundLoad(void)
 	}
 	LOAD_SOUND(SoundPlayerRoll, "roll.ogg");
 
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < MAX_ROLL_CHANNELS; i++)
 	{
 		rollChannels[i] = -1;
 	}
@@ -43,6 +48,7 @@ void SoundFree(void)
 
 void SoundPlay(Mix_Chunk *sound, const float volume)
 {
+	if (Game->Headless) return;
 	const int channel = Mix_PlayChannel(-1, sound, 0);
 	if (channel >= 0)
 	{
@@ -59,6 +65,7 @@ void SoundPlayBounce(const float speed)
 
 void SoundPlayRoll(const int player, const float speed)
 {
+	if (Game->Headless || player >= MAX_ROLL_CHANNELS) return;
 	if (rollChannels[player] == -1)
 	{
 		rollChannels[player] = Mix_PlayChannel(-1, SoundPlayerRoll, -1);
@@ -74,6 +81,7 @@ void SoundPlayRoll(const int player, const float speed)
 
 void SoundStopRoll(const int player)
 {
+	if (Game->Headless || player >= MAX_ROLL_CHANNELS) return;
 	if (rollChannels[player] != -1)
 	{
 		Mix_HaltChannel(rollChannels[player]);
@@ -84,5 +92,6 @@ void SoundStopRoll(const int player)
 
 void MusicSetLoud(const bool fullVolume)
 {
+	if (Game->Headless) return;
 	Mix_VolumeMusic(fullVolume ? MUSIC_VOLUME_HIGH : MUSIC_VOLUME_LOW);
 }
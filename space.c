@@ -25,58 +25,166 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 #include "space.h"
 
+#include <chipmunk/cpHastySpace.h>
+
 #include "box.h"
+#include "context.h"
 #include "game.h"
 #include "gap.h"
 #include "pickup.h"
+#include "rng.h"
 #include "sound.h"
 #include "utils.h"
 
-Space space;
+// Spatial hash cell size (m) and table size
+#define SPACE_HASH_CELL_SIZE 1.0f
+#define SPACE_HASH_CELLS 64
 
-void SpaceInit(Space *s)
+void SpaceInit(Space *s, const int threads, const SpaceIndex index)
 {
 	memset(s, 0, sizeof *s);
+	s->Threads = threads;
+	s->Index = index;
 
-	// Init physics space
-	s->Space = cpSpaceNew();
-	cpSpaceSetIterations(s->Space, 30);
-	cpSpaceSetGravity(s->Space, cpv(0, GRAVITY));
-	cpSpaceSetCollisionSlop(s->Space, 0.5);
-	cpSpaceSetSleepTimeThreshold(s->Space, 1.0f);
-
-	CArrayInit(&s->Gaps, sizeof(struct Gap));
+	CArrayInit(&s->BlockShapes, sizeof(cpShape *));
 
 	SpaceReset(s);
 }
-static void RemoveEdgeShape(cpBody *body, cpShape *shape, void *data);
+static cpSpace *PhysicsSpaceNew(const int threads, const SpaceIndex index);
+static void PhysicsSpaceFree(cpSpace *space, const int threads);
 static void AddEdgeShapes(Space *s, const float y);
+static void FreeBlockShapes(Space *s);
 void SpaceReset(Space *s)
 {
-	if (s->edgeBodies != NULL)
+	for (int i = 0; i < s->NumGaps; i++)
 	{
-		cpBodyEachShape(s->edgeBodies, RemoveEdgeShape, s->Space);
+		GapRemove(SpaceGap(s, i));
 	}
+	s->gapsStart = 0;
+	s->NumGaps = 0;
+	s->gapsFirst = 0;
+	memset(s->nextGap, 0, sizeof s->nextGap);
+	s->gapGenDistance = GAP_GEN_START;
+	s->gapWidth = GAP_WIDTH_MAX;
 
-	// Segments around screen
-	s->edgeBodies = cpSpaceGetStaticBody(s->Space);
-	AddEdgeShapes(s, 0);
-	s->edgeBodiesBottom = -FIELD_HEIGHT * 4;
-
-	for (int i = 0; i < (int)s->Gaps.size; i++)
+	// Start over with a new physics space, freeing all bodies still in it.
+	// Nothing (cached contacts, broadphase layout) carries over from the
+	// previous space, so that games are reproducible.
+	if (s->Space != NULL)
 	{
-		GapRemove(CArrayGet(&s->Gaps, i));
+		FreeBlockShapes(s);
+		PhysicsSpaceFree(s->Space, s->Threads);
 	}
-	CArrayClear(&s->Gaps);
-	s->gapGenDistance = GAP_GEN_START;
-	s->gapWidth = GAP_WIDTH_MAX;
+	s->Space = PhysicsSpaceNew(s->Threads, s->Index);
+
+	// Segments around screen, on their own body so that they can be replaced
+	// without touching the blocks on the static body of the space
+	s->edgeBodies = cpSpaceAddBody(s->Space, cpBodyNewStatic());
+	AddEdgeShapes(s, 0);
 
 	PickupsReset();
 }
 void SpaceFree(Space *s)
 {
-	CArrayTerminate(&s->Gaps);
-	cpSpaceFree(s->Space);
+	for (int i = 0; i < s->NumGaps; i++)
+	{
+		GapRemove(SpaceGap(s, i));
+	}
+	s->NumGaps = 0;
+	FreeBlockShapes(s);
+	CArrayTerminate(&s->BlockShapes);
+	PhysicsSpaceFree(s->Space, s->Threads);
+}
+static void FreeBlockShapes(Space *s)
+{
+	for (int i = 0; i < (int)s->BlockShapes.size; i++)
+	{
+		cpShapeFree(*(cpShape **)CArrayGet(&s->BlockShapes, i));
+	}
+	CArrayClear(&s->BlockShapes);
+}
+void SpaceStep(Space *s, const double dt)
+{
+	if (s->Threads != 0)
+	{
+		cpHastySpaceStep(s->Space, dt);
+	}
+	else
+	{
+		cpSpaceStep(s->Space, dt);
+	}
+}
+static cpSpace *PhysicsSpaceNew(const int threads, const SpaceIndex index)
+{
+	cpSpace *space;
+	if (threads != 0)
+	{
+		space = cpHastySpaceNew();
+		// 0 asks for one thread per core
+		cpHastySpaceSetThreads(
+			space, threads == SPACE_THREADS_ALL ? 0 : (unsigned long)threads);
+	}
+	else
+	{
+		space = cpSpaceNew();
+	}
+	cpSpaceSetIterations(space, 30);
+	cpSpaceSetGravity(space, cpv(0, GRAVITY));
+	cpSpaceSetCollisionSlop(space, 0.5);
+	cpSpaceSetSleepTimeThreshold(space, 1.0f);
+	switch (index)
+	{
+	case SPACE_INDEX_HASH:
+		// Few shapes are ever in the space, so a small table is quickest to
+		// clear each step; these did best in --bench-broadphase
+		cpSpaceUseSpatialHash(space, SPACE_HASH_CELL_SIZE, SPACE_HASH_CELLS);
+		break;
+	case SPACE_INDEX_SWEEP:
+		cpSpaceUseSweepY(space);
+		break;
+	default:
+		break;
+	}
+	return space;
+}
+static void CollectShape(cpShape *shape, void *data);
+static void CollectBody(cpBody *body, void *data);
+static void PhysicsSpaceFree(cpSpace *space, const int threads)
+{
+	CArray items;	// of cpShape * or cpBody *
+	CArrayInit(&items, sizeof(void *));
+	cpSpaceEachShape(space, CollectShape, &items);
+	for (int i = 0; i < (int)items.size; i++)
+	{
+		cpShape *shape = *(cpShape **)CArrayGet(&items, i);
+		cpSpaceRemoveShape(space, shape);
+		cpShapeFree(shape);
+	}
+	CArrayClear(&items);
+	cpSpaceEachBody(space, CollectBody, &items);
+	for (int i = 0; i < (int)items.size; i++)
+	{
+		cpBody *body = *(cpBody **)CArrayGet(&items, i);
+		cpSpaceRemoveBody(space, body);
+		cpBodyFree(body);
+	}
+	CArrayTerminate(&items);
+	if (threads != 0)
+	{
+		cpHastySpaceFree(space);
+	}
+	else
+	{
+		cpSpaceFree(space);
+	}
+}
+static void CollectShape(cpShape *shape, void *data)
+{
+	CArrayPushBack(data, &shape);
+}
+static void CollectBody(cpBody *body, void *data)
+{
+	CArrayPushBack(data, &body);
 }
 
 void SpaceAddBottomEdge(Space *s)
@@ -92,57 +200,66 @@ void SpaceAddBottomEdge(Space *s)
 	cpShapeSetFilter(shape, edgeFilter);
 }
 
+static void RemoveEdgeShape(cpBody *body, cpShape *shape, void *data);
 // As the camera scrolls down, need to create new edge bodies
 void SpaceUpdate(
 	Space *s, const float y, const float cameraY, const float playerMaxY,
 	Player *ps)
 {
-	// Scroll all gaps toward the top...
-	for (int i = (int)s->Gaps.size - 1; i >= 0; i--)
+	// If the player is past a gap, award the player with a point.
+	// Gaps are in descending order, so only the next gap of each player
+	// needs checking, unless several were passed at once.
+	if (ps != NULL)
 	{
-		struct Gap *g = CArrayGet(&s->Gaps, i);
-		if (ps != NULL)
+		const int gapsEnd = s->gapsFirst + s->NumGaps;
+		const float *py = Game->PlayerState.Y;
+		for (int j = 0; j < Game->PlayerState.Count; j++)
 		{
-			// If the player is past a gap, award the player with a
-			// point.
-			for (int j = 0; j < MAX_PLAYERS; j++)
+			while (s->nextGap[j] < gapsEnd &&
+				SpaceGap(s, s->nextGap[j] - s->gapsFirst)->Y >
+				py[j] + PLAYER_RADIUS)
 			{
-				Player *p = ps + j;
-				if (!g->Passed[j] && g->Y > p->y + PLAYER_RADIUS)
-				{
-					g->Passed[j] = true;
-					PlayerScore(p, true);
-				}
+				s->nextGap[j]++;
+				PlayerScore(ps + j, true);
 			}
 		}
-		// Arbitrary limit to eliminate off screen gaps
-		// If a gap is past the top side, remove it.
-		if (GapBottom(g) > playerMaxY + FIELD_HEIGHT * 2)
-		{
-			GapRemove(g);
-			CArrayDelete(&s->Gaps, i);
-		}
+	}
+	// Arbitrary limit to eliminate off screen gaps
+	// If a gap is past the top side, remove it. Gaps are in descending order,
+	// so these are always the first ones.
+	while (s->NumGaps > 0 &&
+		GapBottom(SpaceGap(s, 0)) > playerMaxY + FIELD_HEIGHT * 2)
+	{
+		GapRemove(SpaceGap(s, 0));
+		s->gapsStart = (s->gapsStart + 1) & (SPACE_MAX_GAPS - 1);
+		s->NumGaps--;
+		s->gapsFirst++;
+	}
+	// Gaps that scrolled off unpassed can't be scored any more
+	for (int j = 0; j < Game->PlayerState.Count; j++)
+	{
+		s->nextGap[j] = MAX(s->nextGap[j], s->gapsFirst);
 	}
 
-	// Generate a gap now if needed.
+	// Generate a gap now if needed, unless the ring is full; the next one
+	// then comes as soon as the highest gap goes.
 	const struct Gap *lastGap = NULL;
-	if (s->Gaps.size != 0)
+	if (s->NumGaps != 0)
 	{
-		lastGap = CArrayGet(&s->Gaps, s->Gaps.size - 1);
+		lastGap = SpaceGap(s, s->NumGaps - 1);
 	}
-	if (s->Gaps.size == 0 ||
-		GapBottom(lastGap) - (cameraY - FIELD_HEIGHT * 2) >= s->gapGenDistance)
+	if (s->NumGaps < SPACE_MAX_GAPS && (s->NumGaps == 0 ||
+		GapBottom(lastGap) - (cameraY - FIELD_HEIGHT * 2) >= s->gapGenDistance))
 	{
 		float top = 0;
-		if (s->Gaps.size != 0)
+		if (s->NumGaps != 0)
 		{
 			top = GapBottom(lastGap) - s->gapGenDistance;
 			s->gapGenDistance =
 				MAX(GAP_GEN_MIN, s->gapGenDistance + GAP_GEN_SPEED);
 		}
-		struct Gap g;
-		GapInit(&g, s->gapWidth, top);
-		CArrayPushBack(&s->Gaps, &g);
+		GapInit(SpaceGap(s, s->NumGaps), s->gapWidth, top);
+		s->NumGaps++;
 		s->gapWidth = MAX(GAP_WIDTH_MIN, s->gapWidth + GAP_WIDTH_SHRINK_SPEED);
 	}
 
@@ -153,13 +270,14 @@ void SpaceUpdate(
 	}
 }
 
-void SpaceDraw(const Space *s, const float y)
+int SpaceSprites(const Space *s, DrawSprite *sprites)
 {
-	// Draw the gaps.
-	for (int i = 0; i < (int)s->Gaps.size; i++)
+	int n = 0;
+	for (int i = 0; i < s->NumGaps; i++)
 	{
-		GapDraw(CArrayGet(&s->Gaps, i), y);
+		n += GapSprites(SpaceGap(s, i), &sprites[n]);
 	}
+	return n;
 }
 
 static void RemoveEdgeShape(cpBody *body, cpShape *shape, void *data)
@@ -196,20 +314,122 @@ static void AddEdgeShapes(Space *s, const float y)
 void SpaceRespawnPlayer(Space *s, Player *p)
 {
 	// Spawn the player inside the last gap
-	const struct Gap *lastGap =
-		CArrayGet(&s->Gaps, (int)s->Gaps.size - 1);
+	const struct Gap *lastGap = SpaceGap(s, s->NumGaps - 1);
 	// Select random pair of blocks between which to respawn
-	const int il = rand() % ((int)lastGap->blocks.size - 1);
-	const Block *bl = CArrayGet(&lastGap->blocks, il);
-	const float left = (float)cpBodyGetPosition(bl->Body).x + bl->W / 2;
-	const Block *br = CArrayGet(&lastGap->blocks, il + 1);
-	const float right = (float)cpBodyGetPosition(br->Body).x - br->W / 2;
+	const int il =
+		RngInt(&Game->Rngs[RNG_RESPAWN], lastGap->numBlocks - 1);
+	const Block *bl = &lastGap->blocks[il];
+	const float left = bl->X + bl->W / 2;
+	const Block *br = &lastGap->blocks[il + 1];
+	const float right = br->X - br->W / 2;
 	PlayerRespawn(p, (left + right) / 2, lastGap->Y - GAP_HEIGHT);
 
 	// Mark all gaps as passed for this player
-	for (int i = 0; i < (int)s->Gaps.size; i++)
+	s->nextGap[p->Index] = s->gapsFirst + s->NumGaps;
+}
+
+static const char *indexNames[SPACE_INDEX_COUNT] =
+{
+	"bbtree", "hash", "sweep"
+};
+const char *SpaceIndexName(const SpaceIndex index)
+{
+	return indexNames[index];
+}
+SpaceIndex SpaceIndexParse(const char *name)
+{
+	SpaceIndex i;
+	for (i = 0; i < SPACE_INDEX_COUNT; i++)
 	{
-		struct Gap *g = CArrayGet(&s->Gaps, i);
-		g->Passed[p->Index] = true;
+		if (strcmp(name, indexNames[i]) == 0) break;
 	}
+	return i;
+}
+
+#define BENCH_COLUMNS 40
+#define BENCH_ROWS 40
+#define BENCH_STEPS 300
+static double BenchmarkRun(const int threads, double *checksum);
+void SpaceBenchmark(void)
+{
+	printf(
+		"Physics solver, pile of %d circles, ms per step\n",
+		BENCH_COLUMNS * BENCH_ROWS);
+	printf("%-24s %10s %16s\n", "solver", "ms/step", "checksum");
+	const struct
+	{
+		const char *name;
+		int threads;
+	} solvers[] =
+	{
+		{ "cpSpace", 0 },
+		{ "cpHastySpace, 1 thread", 1 },
+		{ "cpHastySpace, all cores", SPACE_THREADS_ALL },
+	};
+	for (int i = 0; i < (int)(sizeof solvers / sizeof solvers[0]); i++)
+	{
+		double checksum;
+		const double ms = BenchmarkRun(solvers[i].threads, &checksum);
+		printf("%-24s %10.3f %16.6f\n", solvers[i].name, ms, checksum);
+	}
+}
+static void SumPosition(cpBody *body, void *data);
+// Drop a pile of circles into a box and time the steps, returning ms per
+// step; the checksum of the final positions tells diverging solvers apart
+static double BenchmarkRun(const int threads, double *checksum)
+{
+	cpSpace *s = PhysicsSpaceNew(threads, SPACE_INDEX_BBTREE);
+	// Keep the pile awake so that every step solves all of its contacts
+	cpSpaceSetSleepTimeThreshold(s, INFINITY);
+	cpBody *ground = cpSpaceGetStaticBody(s);
+	const float w = BENCH_COLUMNS * 2 + 1;
+	const cpVect corners[] =
+	{
+		cpv(0, BENCH_ROWS * 4), cpv(0, 0), cpv(w, 0), cpv(w, BENCH_ROWS * 4)
+	};
+	for (int i = 0; i < 3; i++)
+	{
+		cpShape *shape = cpSpaceAddShape(
+			s, cpSegmentShapeNew(ground, corners[i], corners[i + 1], 0.0f));
+		cpShapeSetFriction(shape, 1.0f);
+	}
+	for (int y = 0; y < BENCH_ROWS; y++)
+	{
+		for (int x = 0; x < BENCH_COLUMNS; x++)
+		{
+			cpBody *body = cpSpaceAddBody(s, cpBodyNew(
+				1.0f, cpMomentForCircle(1.0f, 0, 1.0f, cpvzero)));
+			// Stagger the rows so that the pile topples and keeps moving
+			cpBodySetPosition(
+				body, cpv(1.5f + x * 2 + (y % 2) * 0.5f, 1 + y * 2.05f));
+			cpShape *shape =
+				cpSpaceAddShape(s, cpCircleShapeNew(body, 1.0f, cpvzero));
+			cpShapeSetFriction(shape, 0.7f);
+		}
+	}
+
+	const Uint32 start = SDL_GetTicks();
+	for (int i = 0; i < BENCH_STEPS; i++)
+	{
+		if (threads != 0)
+		{
+			cpHastySpaceStep(s, 1.0 / 60);
+		}
+		else
+		{
+			cpSpaceStep(s, 1.0 / 60);
+		}
+	}
+	const Uint32 elapsed = SDL_GetTicks() - start;
+
+	*checksum = 0;
+	cpSpaceEachBody(s, SumPosition, checksum);
+	PhysicsSpaceFree(s, threads);
+	return (double)elapsed / BENCH_STEPS;
+}
+static void SumPosition(cpBody *body, void *data)
+{
+	double *sum = data;
+	const cpVect p = cpBodyGetPosition(body);
+	*sum += p.x + p.y;
 }
@@ -28,31 +28,80 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <chipmunk/chipmunk.h>
 
 #include "c_array.h"
+#include "gap.h"
 #include "player.h"
 
 
+// Most gaps alive at once, from above the screen to below it (bot games peak
+// at 15); a power of two
+#define SPACE_MAX_GAPS 32
+// Most blocks of all the gaps
+#define SPACE_MAX_BLOCKS (SPACE_MAX_GAPS * GAP_MAX_BLOCKS)
+
+// Solver threads for SpaceInit: one per core
+#define SPACE_THREADS_ALL -1
+
+// Broadphase used to find the shapes that might be touching
+typedef enum
+{
+	SPACE_INDEX_BBTREE,	// Chipmunk's default bounding box tree
+	SPACE_INDEX_HASH,	// spatial hash
+	SPACE_INDEX_SWEEP,	// sort and sweep along the y axis
+	SPACE_INDEX_COUNT
+} SpaceIndex;
+
 // Represents physical space of the level
 typedef struct
 {
 	cpSpace *Space;
+	// 0 for a plain cpSpace, otherwise the threads of a cpHastySpace
+	int Threads;
+	SpaceIndex Index;
 	cpBody *edgeBodies;
 	float edgeBodiesBottom;
 
-	CArray Gaps;	// of Gap
+	// Ring buffer of gaps, from the highest to the lowest
+	struct Gap Gaps[SPACE_MAX_GAPS];
+	int gapsStart;
+	int NumGaps;
+	// Gaps are numbered in the order they are made; the number of the
+	// highest gap, and of the next gap each player has yet to fall through
+	int gapsFirst;
+	int nextGap[MAX_PLAYERS];
+	// Shapes of removed blocks, kept to reuse for new ones
+	CArray BlockShapes;	// of cpShape *
 	float gapGenDistance;
 	float gapWidth;
 } Space;
 
-extern Space space;
-
-void SpaceInit(Space *s);
+// threads is 0 for the standard single-threaded solver, otherwise the
+// number of threads (or SPACE_THREADS_ALL) for the threaded cpHastySpace.
+// Only single-threaded solving is deterministic.
+void SpaceInit(Space *s, const int threads, const SpaceIndex index);
 void SpaceReset(Space *s);
 void SpaceFree(Space *s);
+void SpaceStep(Space *s, const double dt);
 
 void SpaceAddBottomEdge(Space *s);
 void SpaceUpdate(
 	Space *s, const float y, const float cameraY, const float playerMaxY,
 	Player *players);
-void SpaceDraw(const Space *s, const float y);
+// Fill in the sprites of all the blocks, up to SPACE_MAX_BLOCKS, and return
+// how many
+int SpaceSprites(const Space *s, DrawSprite *sprites);
 
 void SpaceRespawnPlayer(Space *s, Player *p);
+
+// The i-th gap from the top
+static inline struct Gap *SpaceGap(const Space *s, const int i)
+{
+	return (struct Gap *)&s->Gaps[(s->gapsStart + i) & (SPACE_MAX_GAPS - 1)];
+}
+
+const char *SpaceIndexName(const SpaceIndex index);
+// Returns SPACE_INDEX_COUNT if the name isn't recognised
+SpaceIndex SpaceIndexParse(const char *name);
+
+// Time the plain and threaded physics solvers on a contact-heavy pile and
+// print the results; needs no other initialisation
+void SpaceBenchmark(void);
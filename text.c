@@ -26,47 +26,151 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "text.h"
 
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "init.h"
 #include "main.h"
+#include "utils.h"
 
 
-void TextRenderCentered(
-	SDL_Surface *s, TTF_Font *font, const char *text, const int startY,
-	const SDL_Color c)
+void TextAtlasInit(TextAtlas *a, TTF_Font *font)
 {
-	int y = startY;
-	for (;;)
+	memset(a, 0, sizeof *a);
+	a->Font = font;
+	const SDL_Color white = { 255, 255, 255, 255 };
+	a->Color = white;
+	// Render every glyph, then pack them side by side into one surface
+	SDL_Surface *glyphs[TEXT_ATLAS_GLYPHS];
+	int tops[TEXT_ATLAS_GLYPHS];
+	int w = 0;
+	for (int i = 0; i < TEXT_ATLAS_GLYPHS; i++)
 	{
-		// Render the text line-by-line
-		const char *nl = strchr(text, '\n');
-		char buf[256];
-		if (nl != NULL)
+		const Uint16 ch = (Uint16)(TEXT_ATLAS_FIRST + i);
+		int minx, maxy;
+		TTF_GlyphMetrics(
+			font, ch, &minx, NULL, NULL, &maxy, &a->Advances[i]);
+		// Glyph renders are cropped to the glyph; place them in the cell as
+		// TTF_RenderText_Blended places them on the line
+		a->Offsets[i] = minx;
+		tops[i] = TTF_FontAscent(font) - maxy;
+		glyphs[i] = TTF_RenderGlyph_Blended(font, ch, white);
+		if (glyphs[i] != NULL)
 		{
-			const size_t len = nl - text;
-			strncpy(buf, text, len);
-			buf[len] = '\0';
+			w += glyphs[i]->w;
 		}
-		else
+	}
+	const int h = TTF_FontHeight(font);
+	const SDL_PixelFormat *f = NULL;
+	for (int i = 0; i < TEXT_ATLAS_GLYPHS && f == NULL; i++)
+	{
+		if (glyphs[i] != NULL) f = glyphs[i]->format;
+	}
+	if (f != NULL && w > 0)
+	{
+		a->Surface = SDL_CreateRGBSurface(
+			SDL_SWSURFACE | SDL_SRCALPHA, w, h, 32,
+			f->Rmask, f->Gmask, f->Bmask, f->Amask);
+	}
+	if (a->Surface == NULL)
+	{
+		printf("Error: cannot create glyph atlas: %s\n", SDL_GetError());
+	}
+	int x = 0;
+	for (int i = 0; i < TEXT_ATLAS_GLYPHS; i++)
+	{
+		if (glyphs[i] == NULL) continue;
+		SDL_Rect *r = &a->Glyphs[i];
+		r->x = (Sint16)x;
+		r->w = (Uint16)glyphs[i]->w;
+		// Each cell is a full line high, with the glyph on the baseline
+		r->h = (Uint16)h;
+		if (a->Surface != NULL)
 		{
-			strcpy(buf, text);
+			// Copy the glyph as-is, alpha included, rather than blending it
+			SDL_SetAlpha(glyphs[i], 0, SDL_ALPHA_OPAQUE);
+			SDL_Rect dest = { r->x, (Sint16)tops[i], 0, 0 };
+			SDL_BlitSurface(glyphs[i], NULL, a->Surface, &dest);
 		}
+		x += glyphs[i]->w;
+		SDL_FreeSurface(glyphs[i]);
+	}
+}
+void TextAtlasTerminate(TextAtlas *a)
+{
+	SDL_FreeSurface(a->Surface);
+	a->Surface = NULL;
+}
 
-		if (strlen(buf) > 0)
-		{
-			SDL_Surface *t = TTF_RenderText_Blended(font, buf, c);
-			const int x = (SCREEN_WIDTH - t->w) / 2;
-			SDL_Rect dest = { (Sint16)x, (Sint16)y, 0, 0 };
-			SDL_BlitSurface(t, NULL, s, &dest);
+int TextAtlasWidth(const TextAtlas *a, const char *text)
+{
+	int w = 0;
+	for (; *text != '\0' && *text != '\n'; text++)
+	{
+		if (*text < TEXT_ATLAS_FIRST || *text > TEXT_ATLAS_LAST) continue;
+		w += a->Advances[*text - TEXT_ATLAS_FIRST];
+	}
+	return w;
+}
 
-			SDL_FreeSurface(t);
+static void SetColor(TextAtlas *a, const SDL_Color c);
+void TextAtlasDraw(
+	TextAtlas *a, SDL_Surface *s, const char *text, const int x, const int y,
+	const SDL_Color c)
+{
+	if (a->Surface == NULL) return;
+	SetColor(a, c);
+	int penX = x;
+	for (; *text != '\0' && *text != '\n'; text++)
+	{
+		if (*text < TEXT_ATLAS_FIRST || *text > TEXT_ATLAS_LAST) continue;
+		const int i = *text - TEXT_ATLAS_FIRST;
+		if (a->Glyphs[i].w > 0)
+		{
+			SDL_Rect src = a->Glyphs[i];
+			SDL_Rect dest = { (Sint16)(penX + a->Offsets[i]), (Sint16)y, 0, 0 };
+			SDL_BlitSurface(a->Surface, &src, s, &dest);
+		}
+		penX += a->Advances[i];
+	}
+}
+// Rewrite the colour of every pixel, keeping its alpha
+static void SetColor(TextAtlas *a, const SDL_Color c)
+{
+	if (a->Color.r == c.r && a->Color.g == c.g && a->Color.b == c.b) return;
+	a->Color = c;
+	SDL_Surface *s = a->Surface;
+	const Uint32 amask = s->format->Amask;
+	const Uint32 rgb = SDL_MapRGB(s->format, c.r, c.g, c.b) & ~amask;
+	SDL_LockSurface(s);
+	for (int y = 0; y < s->h; y++)
+	{
+		Uint32 *p = (Uint32 *)((Uint8 *)s->pixels + y * s->pitch);
+		for (int x = 0; x < s->w; x++)
+		{
+			p[x] = (p[x] & amask) | rgb;
 		}
-		y += TTF_FontHeight(font);
+	}
+	SDL_UnlockSurface(s);
+}
 
+void TextRenderCentered(
+	SDL_Surface *s, TextAtlas *a, const char *text, const int startY,
+	const SDL_Color c)
+{
+	int y = startY;
+	for (;;)
+	{
+		// Render the text line-by-line
+		const int x = (SCREEN_WIDTH - TextAtlasWidth(a, text)) / 2;
+		TextAtlasDraw(a, s, text, x, y, c);
+		y += TTF_FontHeight(a->Font);
+
+		const char *nl = strchr(text, '\n');
 		if (nl == NULL)
 		{
 			break;
 		}
 		text = nl + 1;
 	}
-}
\ No newline at end of file
+}
@@ -27,6 +27,34 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <SDL_ttf.h>
 
+// Printable ASCII range held in the glyph atlas
+#define TEXT_ATLAS_FIRST ' '
+#define TEXT_ATLAS_LAST '~'
+#define TEXT_ATLAS_GLYPHS (TEXT_ATLAS_LAST - TEXT_ATLAS_FIRST + 1)
+
+// All the glyphs of a font, rasterised once into one surface so that
+// drawing text is a blit per character. Glyphs are stored in one colour and
+// recoloured in place when drawn in a different one.
+typedef struct
+{
+	TTF_Font *Font;
+	SDL_Surface *Surface;
+	SDL_Rect Glyphs[TEXT_ATLAS_GLYPHS];
+	// Horizontal offset of each glyph's image from the pen position
+	int Offsets[TEXT_ATLAS_GLYPHS];
+	int Advances[TEXT_ATLAS_GLYPHS];
+	SDL_Color Color;
+} TextAtlas;
+
+void TextAtlasInit(TextAtlas *a, TTF_Font *font);
+void TextAtlasTerminate(TextAtlas *a);
+// Width of text up to the end of the line
+int TextAtlasWidth(const TextAtlas *a, const char *text);
+// Draw a line of text with its top-left corner at x, y
+void TextAtlasDraw(
+	TextAtlas *a, SDL_Surface *s, const char *text, const int x, const int y,
+	const SDL_Color c);
+
 void TextRenderCentered(
-	SDL_Surface *s, TTF_Font *font, const char *text, const int startY,
+	SDL_Surface *s, TextAtlas *a, const char *text, const int startY,
 	const SDL_Color c);
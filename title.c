@@ -23,54 +23,53 @@
 #include <inttypes.h>
 #include <stdlib.h>
 
-#include "SDL_image.h"
-
 #include "animation.h"
+#include "bot.h"
 #include "box.h"
 #include "main.h"
+#include "context.h"
 #include "high_score.h"
+#include "image.h"
 #include "init.h"
 #include "input.h"
 #include "particle.h"
 #include "platform.h"
 #include "player.h"
+#include "profiler.h"
+#include "render.h"
+#include "replay.h"
 #include "sound.h"
 #include "space.h"
 #include "text.h"
+#include "utils.h"
 #include "game.h"
 #include "bg.h"
 #include "sys_specifics.h"
 
-static bool Start = false;
-static char WelcomeMessage[256];
-static int winnerIndices[MAX_PLAYERS];
-static int winners = 0;
 static Animation TitleAnim;
 static Animation GameOverAnim;
 static HighScoreDisplay HSD;
-SDL_Surface *ControlSurfaces[MAX_PLAYERS];
+SDL_Surface *ControlSurfaces[MAX_HUMAN_PLAYERS];
 #ifdef __GCW0__
 SDL_Surface *ControlSurface0Analog = NULL;
 SDL_Surface *ControlSurface0G = NULL;
 #endif
 
-static Block blocks[MAX_PLAYERS];
-#define BLOCK_WIDTH (FIELD_WIDTH / MAX_PLAYERS * 0.25f)
+#define BLOCK_WIDTH (FIELD_WIDTH / MAX_HUMAN_PLAYERS * 0.25f)
 #define BLOCK_Y (FIELD_HEIGHT * 0.5f)
+#define PAD_X(_i) (((_i) + 1) * FIELD_WIDTH / (t->NumPads + 1))
+#define SCREEN_PAD_X(_i) (((_i) + 1) * SCREEN_WIDTH / (t->NumPads + 1))
 
-// Countdown to start the game automatically; starts when a player is enabled
-static int countdownMs = -1;
 #define COUNTDOWN_START_MS 3999
 
-bool playersEnabled[MAX_PLAYERS];
-
 
 static void TitleScreenEnd(void);
 void TitleScreenGatherInput(bool* Continue)
 {
+	TitleState *t = &Game->Title;
 	SDL_Event ev;
 
-	while (SDL_PollEvent(&ev))
+	while (RenderPollEvent(&ev))
 	{
 		if (IsExitGameEvent(&ev))
 		{
@@ -78,10 +77,14 @@ void TitleScreenGatherInput(bool* Continue)
 			TitleScreenEnd();
 			return;
 		}
+		if (IsProfilerToggleEvent(&ev))
+		{
+			ProfilerToggle();
+		}
 		InputOnEvent(&ev);
-		for (int i = 0; i < MAX_PLAYERS; i++)
+		for (int i = 0; i < t->NumPads; i++)
 		{
-			players[i].AccelX = GetMovement(i);
+			Game->PlayerState.AccelX[i] = GetMovement(i);
 		}
 #ifdef __GCW0__
 		// Enable/disable G-Sensor based on up/down
@@ -96,43 +99,49 @@ void TitleScreenGatherInput(bool* Continue)
 }
 static void TitleScreenEnd(void)
 {
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	TitleState *t = &Game->Title;
+	BlocksRemove(t->Pads, t->NumPads);
+	for (int i = 0; i < Game->PlayerState.Count; i++)
 	{
-		BlockRemove(&blocks[i]);
 		// Kill players that have not been enabled
-		players[i].Enabled = playersEnabled[i];
-		players[i].Alive = playersEnabled[i];
+		Game->PlayerState.Enabled[i] = t->PlayersEnabled[i];
+		Game->PlayerState.Alive[i] = t->PlayersEnabled[i];
 	}
 }
 
 void TitleScreenDoLogic(bool* Continue, bool* Error, Uint32 Milliseconds)
 {
+	TitleState *t = &Game->Title;
 	(void)Continue;
 	(void)Error;
-	cpSpaceStep(space.Space, Milliseconds * 0.001);
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	ProfilerBegin(PROFILER_PHYSICS);
+	SpaceStep(&Game->Space, Milliseconds * 0.001);
+	ProfilerEnd(PROFILER_PHYSICS);
+	PlayersSync();
+	for (int i = 0; i < t->NumPads; i++)
 	{
-		PlayerUpdate(&players[i], Milliseconds);
+		ProfilerBegin(PROFILER_PLAYERS);
+		PlayerUpdate(&Game->Players[i], Milliseconds);
+		ProfilerEnd(PROFILER_PLAYERS);
 
 		// Check which players have fallen below their start pads
-		cpVect pos = cpBodyGetPosition(players[i].Body);
-		if (pos.y < BLOCK_Y)
+		if (Game->PlayerState.Y[i] < BLOCK_Y)
 		{
-			if (!playersEnabled[i])
+			if (!t->PlayersEnabled[i])
 			{
 				// New player entered
-				countdownMs = COUNTDOWN_START_MS;
+				t->CountdownMs = COUNTDOWN_START_MS;
 				SoundPlay(SoundStart, 1.0);
 			}
-			playersEnabled[i] = true;
+			t->PlayersEnabled[i] = true;
 		}
 	}
 
-	if (countdownMs >= 0)
+	if (t->CountdownMs >= 0)
 	{
-		const int countdownMsNext = countdownMs - Milliseconds;
+		const int countdownMsNext = t->CountdownMs - Milliseconds;
 		// Play a beep every second
-		if ((countdownMs / 1000) > (countdownMsNext / 1000))
+		if ((t->CountdownMs / 1000) > (countdownMsNext / 1000))
 		{
 			SoundPlay(SoundBeep, 1.0);
 		}
@@ -143,10 +152,13 @@ void TitleScreenDoLogic(bool* Continue, bool* Error, Uint32 Milliseconds)
 			ToGame();
 			return;
 		}
-		countdownMs = countdownMsNext;
+		t->CountdownMs = countdownMsNext;
 	}
 
-	Animation *a = Start ? &TitleAnim : &GameOverAnim;
+	// The title visuals are shared; leave them to the displayed game
+	if (Game->Headless || Game->Offscreen) return;
+
+	Animation *a = t->Start ? &TitleAnim : &GameOverAnim;
 	AnimationUpdate(a, Milliseconds);
 
 	HighScoreDisplayUpdate(&HSD, Milliseconds);
@@ -156,18 +168,17 @@ static SDL_Surface *GetControlSurface(const int i);
 static void DrawTitleImg(void);
 void TitleScreenOutputFrame(void)
 {
+	TitleState *t = &Game->Title;
 	DrawBackground(&BG, 0);
 
 	HighScoreDisplayDraw(&HSD);
 
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < t->NumPads; i++)
 	{
 		SDL_Surface *s = GetControlSurface(i);
 		SDL_Rect dest =
 		{
-			(Sint16)(
-				SCREEN_X((i + 1) * FIELD_WIDTH / (MAX_PLAYERS + 1)) -
-				s->w / 2),
+			(Sint16)(SCREEN_PAD_X(i) - s->w / 2),
 			(Sint16)((SCREEN_HEIGHT - s->h) / 2 - SCREEN_X(PLAYER_RADIUS)),
 			0,
 			0
@@ -175,25 +186,27 @@ void TitleScreenOutputFrame(void)
 		SDL_BlitSurface(s, NULL, Screen, &dest);
 	}
 
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < Game->PlayerState.Count; i++)
 	{
-		PlayerDraw(&players[i], 0);
+		PlayerDraw(&Game->Players[i], 0);
 	}
 
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < t->NumPads; i++)
 	{
-		BlockDraw(&blocks[i], 0);
+		BlockDraw(&t->Pads[i], 0);
 	}
 
 	DrawTitleImg();
 	// Draw player icons if winners
-	if (!Start)
+	if (!t->Start)
 	{
+		const int shown =
+			MIN(t->Winners, SCREEN_WIDTH / PLAYER_SPRITESHEET_WIDTH);
 		const int left =
-			(SCREEN_WIDTH - PLAYER_SPRITESHEET_WIDTH * winners) / 2;
-		for (int i = 0; i < winners; i++)
+			(SCREEN_WIDTH - PLAYER_SPRITESHEET_WIDTH * shown) / 2;
+		for (int i = 0; i < shown; i++)
 		{
-			const int playerIndex = winnerIndices[i];
+			const int playerIndex = t->WinnerIndices[i];
 			SDL_Rect src = {
 				0, 0, PLAYER_SPRITESHEET_WIDTH, PLAYER_SPRITESHEET_HEIGHT
 			};
@@ -204,14 +217,18 @@ void TitleScreenOutputFrame(void)
 				0, 0
 			};
 			SDL_BlitSurface(
-				PlayerSpritesheets[playerIndex], &src, Screen, &dest);
+				Game->Players[playerIndex].Sprites, &src, Screen, &dest);
 		}
 	}
 	SDL_Color c = { 177, 177, 177, 255 };
 	TextRenderCentered(
-		Screen, font, WelcomeMessage, (int)(SCREEN_HEIGHT * 0.75f), c);
+		Screen, &fontAtlas, t->WelcomeMessage, (int)(SCREEN_HEIGHT * 0.75f), c);
 
+	ProfilerDraw(Screen);
+	ProfilerBegin(PROFILER_FLIP);
 	SDL_Flip(Screen);
+	ProfilerEnd(PROFILER_FLIP);
+	ProfilerFrameEnd(NULL);
 }
 static SDL_Surface *GetControlSurface(const int i)
 {
@@ -237,21 +254,35 @@ static SDL_Surface *GetControlSurface(const int i)
 }
 static void DrawTitleImg(void)
 {
-	const Animation *a = Start ? &TitleAnim : &GameOverAnim;
+	TitleState *t = &Game->Title;
+	const Animation *a = t->Start ? &TitleAnim : &GameOverAnim;
 	AnimationDrawUpperCenter(a, Screen);
 }
 
 void ToTitleScreen(const bool start)
 {
-	countdownMs = -1;
-	ResetMovement();
+	TitleState *t = &Game->Title;
+	// The recorded or replayed game, if any, is over; at startup, a replay
+	// to play has already been opened
+	if (!start)
+	{
+		ReplayEnd(&replay);
+	}
+	t->CountdownMs = -1;
 	MusicSetLoud(false);
-	BackgroundsInit(&BG);
-	Start = start;
-	if (Start)
+	if (!Game->Headless && !Game->Offscreen)
+	{
+		// The title screen draws by itself, and starts the background
+		// again, once the last game frame has been drawn
+		RenderWaitIdle();
+		ResetMovement();
+		BackgroundsInit(&BG);
+	}
+	t->Start = start;
+	if (t->Start)
 	{
 		sprintf(
-			WelcomeMessage,
+			t->WelcomeMessage,
 			"%s to pause\n%s to exit",
 			GetPausePrompt(), GetExitGamePrompt());
 	}
@@ -259,73 +290,107 @@ void ToTitleScreen(const bool start)
 	{
 		// Find out the result of the game
 		int maxScore = 0;
-		for (int i = 0; i < MAX_PLAYERS; i++)
+		for (int i = 0; i < Game->PlayerState.Count; i++)
 		{
-			if (players[i].Score > maxScore) maxScore = players[i].Score;
+			if (Game->Players[i].Score > maxScore) maxScore = Game->Players[i].Score;
 		}
-		winners = 0;
-		for (int i = 0; i < MAX_PLAYERS; i++)
+		t->Winners = 0;
+		GameResult *res = &Game->LastResult;
+		res->Ms = Game->GameMs;
+		res->NumPlayers = Game->PlayerState.Count;
+		res->MaxScore = maxScore;
+		for (int i = 0; i < Game->PlayerState.Count; i++)
 		{
-			if (!players[i].Enabled) continue;
-			if (players[i].Score == maxScore)
+			res->Scores[i] = Game->Players[i].Score;
+			if (!Game->PlayerState.Enabled[i]) continue;
+			if (Game->Players[i].Score == maxScore)
 			{
-				winnerIndices[winners] = i;
-				winners++;
+				t->WinnerIndices[t->Winners] = i;
+				t->Winners++;
 			}
 		}
 		if (PlayerEnabledCount() == 1)
 		{
 			sprintf(
-				WelcomeMessage,
+				t->WelcomeMessage,
 				"Your score was %d!\n%s to exit",
 				maxScore, GetExitGamePrompt());
 		}
-		else if (winners == 1)
+		else if (t->Winners == 1)
 		{
 			sprintf(
-				WelcomeMessage,
+				t->WelcomeMessage,
 				"Wins with score %d!\n%s to exit",
 				maxScore, GetExitGamePrompt());
 		}
 		else
 		{
 			sprintf(
-				WelcomeMessage,
+				t->WelcomeMessage,
 				"Tied with score %d!\n%s to exit",
 				maxScore, GetExitGamePrompt());
 		}
-		HighScoresAdd(maxScore);
+		// Don't fill the high score table with simulated games
+		if (!Game->Headless && !Game->Offscreen)
+		{
+			HighScoresAdd(maxScore);
+		}
+		Game->GamesOver++;
 	}
 
-	HighScoreDisplayInit(&HSD);
+	if (!Game->Headless && !Game->Offscreen)
+	{
+		HighScoreDisplayInit(&HSD);
+	}
 
-	CArrayClear(&Particles);
-	SpaceReset(&space);
+	ParticlesClear();
+	SpaceReset(&Game->Space);
 	// Add bottom edge so we don't fall through
-	SpaceAddBottomEdge(&space);
+	SpaceAddBottomEdge(&Game->Space);
 
 	// Initialise players here
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	t->NumPads = MIN(Game->PlayerState.Count, MAX_HUMAN_PLAYERS);
+	for (int i = 0; i < t->NumPads; i++)
 	{
-		PlayerInit(&players[i], i, cpv(
-			(i + 1) * FIELD_WIDTH / (MAX_PLAYERS + 1),
-			FIELD_HEIGHT * 0.75f));
-		playersEnabled[i] = false;
+		PlayerInit(&Game->Players[i], i, cpv(PAD_X(i), FIELD_HEIGHT * 0.75f));
+		t->PlayersEnabled[i] = false;
+	}
+	for (int i = t->NumPads; i < Game->PlayerState.Count; i++)
+	{
+		Game->Players[i].Index = i;
+		Game->Players[i].Body = NULL;
+		Game->PlayerState.Enabled[i] = false;
+		Game->PlayerState.Alive[i] = false;
+		t->PlayersEnabled[i] = true;
 	}
 
 	// Add platforms for players to jump off
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < t->NumPads; i++)
 	{
 		BlockInit(
-			&blocks[i],
-			(i + 1) * FIELD_WIDTH / (MAX_PLAYERS + 1) - BLOCK_WIDTH / 2,
-			BLOCK_Y,
-			BLOCK_WIDTH);
+			&t->Pads[i], PAD_X(i) - BLOCK_WIDTH / 2, BLOCK_Y, BLOCK_WIDTH);
 	}
+	BlocksAdd(t->Pads, t->NumPads);
+
+	if (replay.Mode == REPLAY_MODE_PLAY)
+		Game->GatherInput = GameReplayGatherInput;
+	else if (Game->Headless)
+		Game->GatherInput = BotGatherInput;
+	else
+		Game->GatherInput = TitleScreenGatherInput;
+	Game->DoLogic     = TitleScreenDoLogic;
+	Game->OutputFrame = TitleScreenOutputFrame;
+}
 
-	GatherInput = TitleScreenGatherInput;
-	DoLogic     = TitleScreenDoLogic;
-	OutputFrame = TitleScreenOutputFrame;
+void TitleScreenStartGame(const bool *enabled)
+{
+	TitleState *t = &Game->Title;
+	for (int i = 0; i < Game->PlayerState.Count; i++)
+	{
+		t->PlayersEnabled[i] = enabled[i];
+	}
+	TitleScreenEnd();
+	ToGame();
 }
 
 bool TitleImagesLoad(void)
@@ -339,7 +404,7 @@ bool TitleImagesLoad(void)
 	{
 		return false;
 	}
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < MAX_HUMAN_PLAYERS; i++)
 	{
 		char buf[256];
 #ifdef __GCW0__
@@ -347,16 +412,16 @@ bool TitleImagesLoad(void)
 #else
 		sprintf(buf, "data/graphics/keyboard%d.png", i);
 #endif
-		ControlSurfaces[i] = IMG_Load(buf);
+		ControlSurfaces[i] = ImageLoad(buf);
 		if (ControlSurfaces[i] == NULL)
 		{
 			return false;
 		}
 	}
 #ifdef __GCW0__
-	ControlSurface0Analog = IMG_Load("data/graphics/gcw0analog.png");
+	ControlSurface0Analog = ImageLoad("data/graphics/gcw0analog.png");
 	if (ControlSurface0Analog == NULL) return false;
-	ControlSurface0G = IMG_Load("data/graphics/gcw0g.png");
+	ControlSurface0G = ImageLoad("data/graphics/gcw0g.png");
 	if (ControlSurface0G == NULL) return false;
 #endif
 	return true;
@@ -365,7 +430,7 @@ void TitleImagesFree(void)
 {
 	AnimationFree(&TitleAnim);
 	AnimationFree(&GameOverAnim);
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	for (int i = 0; i < MAX_HUMAN_PLAYERS; i++)
 	{
 		SDL_FreeSurface(ControlSurfaces[i]);
 	}
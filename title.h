@@ -23,7 +23,30 @@
 
 #include <SDL.h>
 
+#include "box.h"
+#include "player.h"
+
+// The title screen's part of a game context
+typedef struct
+{
+	// Showing the title, rather than the result of the last game
+	bool Start;
+	char WelcomeMessage[256];
+	int WinnerIndices[MAX_PLAYERS];
+	int Winners;
+	// Only human players get a pad and controls shown; bots sit out the
+	// title screen, but join each game
+	Block Pads[MAX_HUMAN_PLAYERS];
+	int NumPads;
+	// Countdown to start the game automatically; starts when a player is
+	// enabled
+	int CountdownMs;
+	bool PlayersEnabled[MAX_PLAYERS];
+} TitleState;
+
 void ToTitleScreen(const bool start);
+// Skip the title screen and start a game with the given players
+void TitleScreenStartGame(const bool *enabled);
 
 bool TitleImagesLoad(void);
 void TitleImagesFree(void);
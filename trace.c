@@ -0,0 +1,149 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <chipmunk/chipmunk.h>
+
+#include "utils.h"
+
+#ifdef _WIN32
+#include <SDL.h>
+#endif
+
+#ifdef __GNUC__
+#define ATOMIC_INC(x) __sync_fetch_and_add(&(x), 1)
+#else
+#define ATOMIC_INC(x) ((x)++)
+#endif
+
+// Deepest nesting of scopes on one thread
+#define TRACE_MAX_DEPTH 32
+
+typedef struct
+{
+	const char *Name;
+	uint64_t Start;
+	uint32_t Dur;
+	uint32_t Tid;
+} TraceEvent;
+
+bool TraceEnabled = false;
+
+static char *traceFilename = NULL;
+static TraceEvent *events = NULL;
+// Total events ever written; the slot is this masked by the capacity
+static volatile uint32_t writeIndex = 0;
+static volatile uint32_t threadCount = 0;
+static uint64_t startUs;
+
+typedef struct
+{
+	const char *Name;
+	uint64_t Start;
+} TraceScope;
+static THREAD_LOCAL TraceScope scopes[TRACE_MAX_DEPTH];
+static THREAD_LOCAL int depth = 0;
+static THREAD_LOCAL uint32_t tid = 0;
+
+uint64_t TraceNowUs(void)
+{
+#ifdef _WIN32
+	return (uint64_t)SDL_GetTicks() * 1000;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static void ChipmunkTrace(const char *name, cpBool begin)
+{
+	if (begin)
+	{
+		TraceBegin(name);
+	}
+	else
+	{
+		TraceEnd();
+	}
+}
+
+void TraceInit(const char *filename)
+{
+	CMALLOC(events, sizeof *events * TRACE_CAPACITY);
+	CSTRDUP(traceFilename, filename);
+	writeIndex = 0;
+	startUs = TraceNowUs();
+	TraceEnabled = true;
+	cpTraceHook = ChipmunkTrace;
+}
+
+static void TraceWrite(void);
+void TraceFree(void)
+{
+	if (!TraceEnabled) return;
+	TraceEnabled = false;
+	cpTraceHook = NULL;
+	TraceWrite();
+	CFREE(events);
+	events = NULL;
+	CFREE(traceFilename);
+	traceFilename = NULL;
+}
+
+void TraceBegin(const char *name)
+{
+	if (!TraceEnabled) return;
+	if (depth < TRACE_MAX_DEPTH)
+	{
+		scopes[depth].Name = name;
+		scopes[depth].Start = TraceNowUs();
+	}
+	depth++;
+}
+void TraceEnd(void)
+{
+	if (!TraceEnabled || depth == 0) return;
+	depth--;
+	if (depth >= TRACE_MAX_DEPTH) return;
+	if (tid == 0)
+	{
+		tid = ATOMIC_INC(threadCount) + 1;
+	}
+	const uint64_t now = TraceNowUs();
+	TraceEvent *e = &events[ATOMIC_INC(writeIndex) & (TRACE_CAPACITY - 1)];
+	e->Name = scopes[depth].Name;
+	e->Start = scopes[depth].Start - startUs;
+	e->Dur = (uint32_t)(now - scopes[depth].Start);
+	e->Tid = tid;
+}
+
+// Write the buffered events as complete ("X") events, oldest first
+static void TraceWrite(void)
+{
+	FILE *f = fopen(traceFilename, "w");
+	if (f == NULL)
+	{
+		printf("Error: cannot write trace %s\n", traceFilename);
+		return;
+	}
+	const uint32_t end = writeIndex;
+	const uint32_t start = end > TRACE_CAPACITY ? end - TRACE_CAPACITY : 0;
+	fprintf(f, "{\"traceEvents\":[\n");
+	for (uint32_t i = start; i < end; i++)
+	{
+		const TraceEvent *e = &events[i & (TRACE_CAPACITY - 1)];
+		fprintf(
+			f,
+			"{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%u,"
+			"\"pid\":1,\"tid\":%u}%s\n",
+			e->Name, (unsigned long long)e->Start, (unsigned)e->Dur,
+			(unsigned)e->Tid, i + 1 < end ? "," : "");
+	}
+	fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(f);
+	printf("Wrote %u trace events to %s\n", (unsigned)(end - start), traceFilename);
+}
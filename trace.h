@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Chrome trace-event recording. Scoped events from the main loop and the
+// physics step are written into an in-memory ring buffer, keeping the most
+// recent TRACE_CAPACITY events, and written out as a JSON trace on exit.
+// Open the file in chrome://tracing or https://ui.perfetto.dev
+
+// Must be a power of two
+#define TRACE_CAPACITY (1 << 17)
+
+extern bool TraceEnabled;
+
+// Start recording; the trace is written to filename by TraceFree
+void TraceInit(const char *filename);
+void TraceFree(void);
+
+// Begin and end must be properly nested on each thread
+void TraceBegin(const char *name);
+void TraceEnd(void);
+
+// Monotonic clock used for the event timestamps
+uint64_t TraceNowUs(void);
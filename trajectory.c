@@ -0,0 +1,163 @@
+#include "trajectory.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "context.h"
+#include "game.h"
+#include "utils.h"
+
+// File layout, all integers little-endian:
+//   "FTTJ", version (u8), player count (u8)
+// followed by one record per frame, per player:
+//   X, Y (f32 bits as u32), NaN if the player isn't alive
+#define TRAJECTORY_MAGIC "FTTJ"
+#define TRAJECTORY_VERSION 1
+
+Trajectory trajectory;
+
+static void WriteF32(FILE *f, const float v);
+static bool ReadF32(FILE *f, float *v);
+
+void TrajectoryInit(
+	Trajectory *t, const TrajectoryMode mode, const char *filename)
+{
+	memset(t, 0, sizeof *t);
+	t->Mode = mode;
+	t->Filename = filename;
+}
+bool TrajectoryStart(Trajectory *t, const int count)
+{
+	if (t->Mode == TRAJECTORY_MODE_NONE) return true;
+	t->f = fopen(t->Filename, t->Mode == TRAJECTORY_MODE_SAVE ? "wb" : "rb");
+	if (t->f == NULL)
+	{
+		printf("Error: cannot open trajectory file %s\n", t->Filename);
+		return false;
+	}
+	t->Count = count;
+	t->Frames = 0;
+	t->Samples = 0;
+	t->SumError = 0;
+	t->MaxError = 0;
+	t->DivergedFrame = -1;
+	t->AliveMismatches = 0;
+	if (t->Mode == TRAJECTORY_MODE_SAVE)
+	{
+		fwrite(TRAJECTORY_MAGIC, 1, strlen(TRAJECTORY_MAGIC), t->f);
+		fputc(TRAJECTORY_VERSION, t->f);
+		fputc(t->Count, t->f);
+		return true;
+	}
+	char magic[sizeof TRAJECTORY_MAGIC - 1];
+	if (fread(magic, 1, sizeof magic, t->f) != sizeof magic ||
+		memcmp(magic, TRAJECTORY_MAGIC, sizeof magic) != 0 ||
+		fgetc(t->f) != TRAJECTORY_VERSION)
+	{
+		printf("Error: %s is not a compatible trajectory\n", t->Filename);
+		fclose(t->f);
+		t->f = NULL;
+		return false;
+	}
+	if (fgetc(t->f) != t->Count)
+	{
+		printf(
+			"Error: %s is for a different number of players\n", t->Filename);
+		fclose(t->f);
+		t->f = NULL;
+		return false;
+	}
+	return true;
+}
+void TrajectoryFrame(Trajectory *t)
+{
+	if (t->f == NULL) return;
+	const PlayerState *ps = &Game->PlayerState;
+	if (t->Mode == TRAJECTORY_MODE_SAVE)
+	{
+		for (int i = 0; i < t->Count; i++)
+		{
+			WriteF32(t->f, ps->Alive[i] ? ps->X[i] : NAN);
+			WriteF32(t->f, ps->Alive[i] ? ps->Y[i] : NAN);
+		}
+		return;
+	}
+	for (int i = 0; i < t->Count; i++)
+	{
+		float x, y;
+		if (!ReadF32(t->f, &x) || !ReadF32(t->f, &y))
+		{
+			// The saved run was shorter; stop checking there
+			fclose(t->f);
+			t->f = NULL;
+			return;
+		}
+		if (isnan(x) != !ps->Alive[i])
+		{
+			t->AliveMismatches++;
+			continue;
+		}
+		if (!ps->Alive[i]) continue;
+		const float error = hypotf(ps->X[i] - x, ps->Y[i] - y);
+		t->SumError += error;
+		t->MaxError = MAX(t->MaxError, error);
+		t->Samples++;
+		if (error > PLAYER_RADIUS && t->DivergedFrame < 0)
+		{
+			t->DivergedFrame = t->Frames;
+		}
+	}
+	t->Frames++;
+}
+void TrajectoryEnd(Trajectory *t)
+{
+	if (t->Mode == TRAJECTORY_MODE_CHECK && t->Count > 0)
+	{
+		printf(
+			"Trajectory: %d frames checked against %s, player error mean "
+			"%.6f, max %.6f\n",
+			t->Frames, t->Filename,
+			t->Samples > 0 ? t->SumError / t->Samples : 0.0,
+			(double)t->MaxError);
+		if (t->DivergedFrame >= 0)
+		{
+			printf(
+				"  first off by more than a player radius at frame %d\n",
+				t->DivergedFrame);
+		}
+		if (t->AliveMismatches > 0)
+		{
+			printf(
+				"  %d times a player was alive in only one run\n",
+				t->AliveMismatches);
+		}
+	}
+	if (t->f != NULL)
+	{
+		fclose(t->f);
+		t->f = NULL;
+	}
+	t->Count = 0;
+}
+
+static void WriteF32(FILE *f, const float v)
+{
+	uint32_t u;
+	memcpy(&u, &v, sizeof u);
+	for (int i = 0; i < 4; i++)
+	{
+		fputc((u >> (i * 8)) & 0xff, f);
+	}
+}
+static bool ReadF32(FILE *f, float *v)
+{
+	uint32_t u = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		const int c = fgetc(f);
+		if (c == EOF) return false;
+		u |= (uint32_t)c << (i * 8);
+	}
+	memcpy(v, &u, sizeof *v);
+	return true;
+}
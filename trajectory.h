@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Player positions of a headless run, saved frame by frame or checked
+// against a saved run, e.g. to see how far builds with different physics
+// precision drift apart. Play the same replay in both runs so that the
+// inputs are the same.
+
+typedef enum
+{
+	TRAJECTORY_MODE_NONE,
+	TRAJECTORY_MODE_SAVE,
+	TRAJECTORY_MODE_CHECK
+} TrajectoryMode;
+
+typedef struct
+{
+	TrajectoryMode Mode;
+	const char *Filename;
+	FILE *f;
+	int Count;
+
+	// Frames checked, and the players alive in both runs over them
+	int Frames;
+	int Samples;
+	double SumError;
+	float MaxError;
+	// First frame that a player was more than their radius off, or -1
+	int DivergedFrame;
+	// A player was alive in one run but not the other
+	int AliveMismatches;
+} Trajectory;
+
+extern Trajectory trajectory;
+
+void TrajectoryInit(
+	Trajectory *t, const TrajectoryMode mode, const char *filename);
+// Open the file for count players
+bool TrajectoryStart(Trajectory *t, const int count);
+// Save or check the positions of the current frame
+void TrajectoryFrame(Trajectory *t);
+// Close the file, and when checking, print how far the runs were apart
+void TrajectoryEnd(Trajectory *t);
@@ -44,6 +44,12 @@
 #define SIGN(_x) ((_x) < 0 ? -1 : 1)
 #define UNUSED(expr) (void)(expr)
 
+#ifdef __GNUC__
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+
 #ifdef _MSC_VER
 #define CHALT() __debugbreak()
 #else